@@ -23,28 +23,229 @@
 // OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
 // DEALINGS IN THE SOFTWARE.
 */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdarg.h>
+#include <math.h>
+#include <ctype.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <intrin.h>
+#include <io.h>
+#include <winsock2.h>
+#ifdef WATCHLIST_BENCHMARK
+#include <psapi.h>
+#endif
+#else
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef WATCHLIST_BENCHMARK
+#include <sys/resource.h>
+#endif
+#if defined(WATCHLIST_BENCHMARK) || defined(WATCHLIST_STATS)
+#include <time.h>
+#endif
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 #ifndef _countof
 #define _countof(a) (sizeof(a) / sizeof(a[0]))
 #endif
 
 /*
-// Encapsulates a Movie.
+// Encapsulates a Movie. Titles live in the string arena of the Movie's pool, and Movies link to
+// each other by MovieId, see getMovie, which keeps a node at 64 bytes.
 */
+#define MAX_TITLE_LENGTH 255
+#define MAX_GENRE_LENGTH 34
+
+typedef uint32_t MovieId;  /* slab number << 16 | index within the slab, 0 for none */
+
 typedef struct Movie
 {
-	char          title[35];
-	char          genre[35];
-	double        duration;  /* hours */
-	struct Movie* next;
+	const char*    title;        /* null-terminated, see storeString */
+	double         duration;     /* hours */
+	unsigned int   titleHash;
+	MovieId        id;
+	MovieId        next;
+	MovieId        prev;
+	MovieId        genrePrev;    /* links within the list's genre bucket */
+	MovieId        genreNext;
+	MovieId        orderParent;  /* links within the list's order index */
+	MovieId        orderLeft;
+	MovieId        orderRight;
+	unsigned int   orderSize;    /* Movies in this order subtree, 0 when in no list */
+	unsigned short genreId;      /* see getGenreName */
+	unsigned char  titleLength;  /* at most MAX_TITLE_LENGTH */
+	unsigned char  catalog;      /* the library file the Movie was loaded from, see getCatalogName */
 } Movie;
 
+/*
+// Open-addressing (linear probing) hash index of Movies keyed on title.
+*/
+typedef struct TitleIndex
+{
+	Movie**      slots;
+	unsigned int capacity;  /* zero or a power of two */
+	unsigned int count;
+} TitleIndex;
+
+/*
+// Structure-of-arrays copy of a linked list of Movies for bulk analytics. Durations, genre ids
+// and title offsets are each contiguous so aggregates run as sequential loops.
+*/
+typedef struct MovieColumns
+{
+	int           count;
+	double*       durations;     /* hours */
+	unsigned int* genreIds;      /* see getGenreName */
+	unsigned int* titleOffsets;  /* offsets of null-terminated titles in titles */
+	char*         titles;
+	unsigned int  revision;      /* the list revision the columns were built from */
+} MovieColumns;
+
+/*
+// The Movies of one genre within a linked list of Movies, linked through Movie::genreNext.
+*/
+typedef struct GenreBucket
+{
+	Movie* head;
+	Movie* tail;
+	int    count;
+	double duration;  /* running total in hours, see addCompensated */
+	double durationCompensation;
+} GenreBucket;
+
+/*
+// Search index over the titles of a linked list of Movies, see buildTitleSearchIndex.
+*/
+typedef struct TitleSearchIndex
+{
+	char*         titles;         /* copies of the titles, null-terminated */
+	unsigned int* sorted;         /* offsets into titles, sorted ignoring case */
+	int           count;
+	unsigned int* trigramKeys;    /* distinct trigrams, ascending */
+	unsigned int* trigramStarts;  /* start of each trigram's postings, trigramCount + 1 entries */
+	unsigned int* postings;       /* sorted positions of the titles containing each trigram */
+	int           trigramCount;
+	char**        extra;          /* titles that joined the list after the build */
+	int           extraCount;
+	int           extraCapacity;
+	bool          stale;          /* a joining title could not be recorded */
+} TitleSearchIndex;
+
+/*
+// Orders a linked list of Movies can be sorted or viewed in, see sortMovieList. Ties are broken by
+// title, so every order is total over a list.
+*/
+typedef enum MovieOrder
+{
+	ByTitle    = 0,  /* ignoring case */
+	ByDuration = 1,  /* shortest first */
+	ByGenre    = 2
+} MovieOrder;
+
+#define MOVIE_ORDER_COUNT 3
+
+static const char* movieOrderNames[MOVIE_ORDER_COUNT] = {"title", "duration", "genre"};
+
+/*
+// The Movies of a linked list in a given order, see getSortedView.
+*/
+typedef struct SortedView
+{
+	Movie**      movies;
+	int          count;
+	unsigned int revision;  /* the list revision the view was built from */
+} SortedView;
+
+/*
+// Encapsulates a linked list of Movies along with its indexes.
+*/
+typedef struct MovieList
+{
+	Movie*        head;
+	Movie*        tail;
+	int           count;
+	unsigned int  revision;  /* incremented on every change */
+	double        duration;  /* running total in hours, see trackDuration */
+	double        durationCompensation;
+	TitleIndex    titleIndex;
+	GenreBucket*  genreBuckets;  /* indexed by genre id */
+	int           genreBucketCount;
+	TitleSearchIndex* searchIndex;  /* optional, see getTitleSearchIndex */
+	MovieColumns* columns;   /* built on demand, see getMovieColumns */
+	SortedView*   sortedViews[MOVIE_ORDER_COUNT];  /* built on demand, see getSortedView */
+	Movie*        orderRoot; /* see Order Index */
+	struct LazyCatalog* catalog;  /* lazy libraries only, see findLibraryMovie */
+	struct Journal* journal;      /* watchlists only, see startJournal */
+	struct MoviePool* pool;       /* the pool its Movies are released to, NULL for moviePool */
+} MovieList;
+
+/*
+// A contiguous block of Movie nodes handed out by a MoviePool.
+*/
+typedef struct MovieSlab
+{
+	struct MovieSlab* next;
+	int               capacity;
+	int               used;
+	unsigned int      number;  /* see registerMovieSlab */
+	Movie*            movies;
+} MovieSlab;
+
+/*
+// A block of the string arena of a MoviePool.
+*/
+typedef struct StringChunk
+{
+	struct StringChunk* next;
+	size_t              capacity;
+	size_t              used;
+	char*               data;
+} StringChunk;
+
+/*
+// Slab allocator for Movie nodes and their titles. Released nodes are kept on a free list (linked
+// through Movie::next) for reuse, and slabs and strings are only returned to the heap in bulk.
+*/
+typedef struct MoviePool
+{
+	MovieSlab*   slabs;
+	Movie*       freeList;
+	int          liveCount;
+	StringChunk* strings;
+} MoviePool;
+
+#define MOVIE_SLAB_MIN_CAPACITY 64
+#define MOVIE_SLAB_MAX_CAPACITY 65536  /* the index bits of a MovieId */
+#define MOVIE_SLAB_MAX_COUNT    65536  /* the slab number bits of a MovieId, number 0 unused */
+#define STRING_CHUNK_CAPACITY   (64 * 1024)
+
+/*
+// The pool all Movie nodes are allocated from.
+*/
+static MoviePool moviePool = {0};
+
 /*
 // Page break.
 */
@@ -55,1393 +256,11366 @@ void pageBreak()
 }
 
 /*
-// Dynamically allocates and creates a Movie.
+// Computes the FNV-1a hash of a given title.
 //
-// [in] title	 - The title of the Movie
-// [in] genre    - The genre of the Movie
-// [in] duration - The duration of the Movie in hours
+// [in] title - The title to hash
 //
-// Returns the created movie, or NULL on error.
+// Returns the hash of the title.
 */
-Movie* createMovieNode(char* title, char* genre, double duration)
+unsigned int hashTitle(const char* title)
 {
-	int    status = 0;
-	Movie* movie  = NULL;
-	int    titleLength = 0;
-	int    genreLength = 0;
+	unsigned int hash = 2166136261u;
 
-	if (status == 0)
+	while (*title != '\0')
 	{
-		if (title == NULL || genre == NULL)
-		{
-			status = EINVAL;
-		}
-		else if ((titleLength = strlen(title)) > _countof(movie->title) - 1)
-		{
-			status = ERANGE;
-		}
-		else if ((genreLength = strlen(genre)) > _countof(movie->genre) - 1)
-		{
-			status = ERANGE;
-		}
+		hash ^= (unsigned char)*title++;
+		hash *= 16777619u;
 	}
 
-	if (status == 0)
-	{
-		movie = calloc(1, sizeof(Movie));
+	return hash;
+}
 
-		if (movie == NULL)
-		{
-			status = ENOMEM;
-		}
-	}
+/*
+// Computes the FNV-1a hash of a given title that is not null-terminated, equal to hashTitle of
+// the same characters.
+//
+// [in] title  - The title to hash
+// [in] length - The length of the title
+//
+// Returns the hash of the title.
+*/
+unsigned int hashBytes(const char* title, size_t length)
+{
+	unsigned int hash = 2166136261u;
+	size_t       i    = 0;
 
-	if (status == 0)
+	for (i = 0; i < length; ++i)
 	{
-		if (title != NULL || strlen(title) > 35)
-		{
-			strcpy(movie->title, title);
-		}
+		hash ^= (unsigned char)title[i];
+		hash *= 16777619u;
+	}
 
-		if (genre != NULL || strlen(title) > 35)
-		{
-			strcpy(movie->genre, genre);
-		}
+	return hash;
+}
 
-		movie->duration = duration;
-	}
+/*=========================================================================================================
+// Threading
+//=======================================================================================================*/
 
-	if (status != 0)
-	{
-		free(movie);
-		movie = NULL;
-		errno = status;
-	}
+/*
+// Encapsulates a mutual exclusion lock that can be initialized statically with MUTEX_INITIALIZER.
+*/
+typedef struct Mutex
+{
+#ifdef _WIN32
+	SRWLOCK         handle;
+#else
+	pthread_mutex_t handle;
+#endif
+} Mutex;
 
-	return movie;
+#ifdef _WIN32
+#define MUTEX_INITIALIZER {SRWLOCK_INIT}
+#else
+#define MUTEX_INITIALIZER {PTHREAD_MUTEX_INITIALIZER}
+#endif
+
+/*
+// Acquires a given mutex.
+//
+// [in] mutex - The mutex
+*/
+void lockMutex(Mutex* mutex)
+{
+#ifdef _WIN32
+	AcquireSRWLockExclusive(&mutex->handle);
+#else
+	pthread_mutex_lock(&mutex->handle);
+#endif
 }
 
 /*
-// Prompts for a string value.
+// Releases a given mutex.
 //
-// [in] buffer     - The input buffer
-// [in] bufferSize - The byte size of the input buffer
-// [in] prompt     - The prompt printed to the user
-// [in] ...        - Additional arguments for a formatted prompt
+// [in] mutex - The mutex
+*/
+void unlockMutex(Mutex* mutex)
+{
+#ifdef _WIN32
+	ReleaseSRWLockExclusive(&mutex->handle);
+#else
+	pthread_mutex_unlock(&mutex->handle);
+#endif
+}
+
+typedef void (*ThreadFunction)(void* argument);
+
+/*
+// Encapsulates a thread of execution running a given function.
+*/
+typedef struct Thread
+{
+#ifdef _WIN32
+	HANDLE         handle;
+#else
+	pthread_t      handle;
+#endif
+	ThreadFunction function;
+	void*          argument;
+} Thread;
+
+#ifdef _WIN32
+DWORD WINAPI runThread(LPVOID thread)
+{
+	((Thread*)thread)->function(((Thread*)thread)->argument);
+	return 0;
+}
+#else
+void* runThread(void* thread)
+{
+	((Thread*)thread)->function(((Thread*)thread)->argument);
+	return NULL;
+}
+#endif
+
+/*
+// Starts a given thread running a given function. The thread must stay in place until joined.
 //
-// Returns the length of the input string, or EOF on error.
+// [in] thread   - The thread
+// [in] function - The function to run
+// [in] argument - The argument passed to the function
+//
+// Returns error status code.
 */
-int promptFor(char* buffer, int bufferSize, const char* prompt, ...)
+int startThread(Thread* thread, ThreadFunction function, void* argument)
 {
-	int newLength      = EOF;
-	int originalLength = 0;
-	int character      = 0;
+	int status = 0;
 
-	if (buffer != NULL && bufferSize > 0)
+	thread->function = function;
+	thread->argument = argument;
+
+#ifdef _WIN32
+	thread->handle = CreateThread(NULL, 0, runThread, thread, 0, NULL);
+
+	if (thread->handle == NULL)
 	{
-		*buffer = '\0';
+		status = EAGAIN;
+	}
+#else
+	status = pthread_create(&thread->handle, NULL, runThread, thread);
+#endif
 
-		if (prompt != NULL)
-		{
-			va_list alist;
-			va_start(alist, prompt);
+	return status;
+}
 
-			vprintf(prompt, alist);
+/*
+// Waits for a given thread to finish.
+//
+// [in] thread - The thread
+*/
+void joinThread(Thread* thread)
+{
+#ifdef _WIN32
+	WaitForSingleObject(thread->handle, INFINITE);
+	CloseHandle(thread->handle);
+#else
+	pthread_join(thread->handle, NULL);
+#endif
+}
 
-			va_end(alist);
-		}
+/*
+// Returns the count of online processors, at least 1.
+*/
+int getProcessorCount()
+{
+	int count = 1;
 
-		if (fgets(buffer, bufferSize, stdin))
-		{
-			/*
-			// Trim the trailing newlines from the input string:
-			*/
-			originalLength = strlen(buffer);
+#ifdef _WIN32
+	SYSTEM_INFO info;
 
-			newLength = originalLength;
+	GetSystemInfo(&info);
+	count = (int)info.dwNumberOfProcessors;
+#else
+	count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
 
-			while (newLength > 0 && buffer[newLength - 1] == '\n')
-			{
-				buffer[--newLength] = '\0';
-			}
+	return count < 1 ? 1 : count;
+}
 
-			/*
-			// Clear the input buffer if we didn't see a newline:
-			*/
-			if (originalLength == newLength)
-			{
-				while (!feof(stdin))
-				{
-					character = fgetc(stdin);
+/*=========================================================================================================
+// Stats
+//=======================================================================================================*/
 
-					if (character <= EOF || character == '\n')
-					{
-						break;
-					}
-				}
-			}
-		}
-	}
+#if defined(WATCHLIST_BENCHMARK) || defined(WATCHLIST_STATS)
+/*
+// Returns a monotonic time in seconds.
+*/
+double getSeconds()
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter   = {0};
+	LARGE_INTEGER frequency = {0};
 
-	return newLength;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&frequency);
+
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+	struct timespec now = {0};
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+#endif
 }
 
+#endif
+
+#ifdef WATCHLIST_STATS
+#define STATS_MAX_COMMANDS 20
+
 /*
-// Prompts for an integer between a given range (inclusively).
+// Timing of one menu command.
+*/
+typedef struct CommandStats
+{
+	const char*        name;
+	unsigned long long count;
+	double             totalSeconds;
+	double             maxSeconds;
+} CommandStats;
+
+/*
+// Counters of the hot paths. Server sessions, loader threads and background saves update them
+// concurrently, so every update is an atomic add, see addStat.
+*/
+typedef struct Stats
+{
+	unsigned long long titleLookups;  /* findInTitleIndex calls */
+	unsigned long long titleHits;
+	unsigned long long titleProbes;   /* slots visited by those lookups */
+	unsigned long long orderWalks;    /* getMoviePosition and getMovieAt calls */
+	unsigned long long orderSteps;    /* order index nodes visited by those walks */
+	unsigned long long nodesCreated;  /* Movie nodes created from moviePool */
+	unsigned long long nodeFailures;
+	unsigned long long bytesRead;
+	unsigned long long bytesWritten;
+	CommandStats       commands[STATS_MAX_COMMANDS];
+} Stats;
+
+static Stats stats = {0};
+
+#define STATS_ADD(counter, value)      addStat(&stats.counter, (unsigned long long)(value))
+#define STATS_ADD_FILE(counter, file)  addFileStats(&stats.counter, (file))
+#define STATS_TIMER(start)             double start = getSeconds()
+#define STATS_COMMAND(id, name, start) recordCommandStats((id), (name), getSeconds() - (start))
+
+/*
+// Atomically adds a given value to a given counter. The counters are only read once the threads
+// updating them are done, so no ordering is needed.
 //
-// [in] minValue - The minimum value allowed
-// [in] maxValue - The maximum value allowed
-// [in] prompt   - The prompt printed to the user
+// [in] counter - The counter
+// [in] value   - The value to add
+*/
+void addStat(unsigned long long* counter, unsigned long long value)
+{
+#ifdef _WIN32
+	InterlockedExchangeAdd64((volatile LONG64*)counter, (LONG64)value);
+#else
+	__atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+#endif
+}
+
+/*
+// Adds the current position of a given file, i.e. the bytes read or written through it so far, to
+// a given counter.
 //
-// Returns the input integer.
+// [in] counter - The counter
+// [in] file    - The file
 */
-int promptForInt(int minValue, int maxValue, const char* prompt)
+void addFileStats(unsigned long long* counter, FILE* file)
 {
-	char  buffer[100] = {0};
-	char* remainder   = buffer;
-	int   integer     = 0;
+	long position = ftell(file);
 
-	while (true)
+	if (position > 0)
 	{
-		promptFor(buffer, _countof(buffer), prompt);
+		addStat(counter, (unsigned long long)position);
+	}
+}
 
-		integer = strtol(buffer, &remainder, 10);
+/*
+// Records the latency of a given menu command.
+//
+// [in] id      - The menu option of the command
+// [in] name    - The name of the command
+// [in] seconds - The time the command took
+*/
+void recordCommandStats(int id, const char* name, double seconds)
+{
+	CommandStats* command = NULL;
+
+	if (id >= 0 && id < STATS_MAX_COMMANDS)
+	{
+		command       = &stats.commands[id];
+		command->name = name;
+
+		++command->count;
+		command->totalSeconds += seconds;
+
+		if (seconds > command->maxSeconds)
+		{
+			command->maxSeconds = seconds;
+		}
+	}
+}
+
+/*
+// Writes the counters and command latencies to a given file.
+//
+// [in] output - The file to write to
+*/
+void writeStats(FILE* output)
+{
+	const CommandStats* command = NULL;
+	int                 i       = 0;
+
+	fprintf(output, "Title lookups: %llu (%llu found, %.2f probes per lookup)\n", stats.titleLookups, stats.titleHits,
+		stats.titleLookups == 0 ? 0.0 : (double)stats.titleProbes / (double)stats.titleLookups);
+	fprintf(output, "Order walks:   %llu (%.2f nodes per walk)\n", stats.orderWalks,
+		stats.orderWalks == 0 ? 0.0 : (double)stats.orderSteps / (double)stats.orderWalks);
+	fprintf(output, "Nodes created: %llu (%llu failed)\n", stats.nodesCreated, stats.nodeFailures);
+	fprintf(output, "Bytes read:    %llu\n", stats.bytesRead);
+	fprintf(output, "Bytes written: %llu\n", stats.bytesWritten);
+	fprintf(output, "\n");
+	fprintf(output, "%-24s %8s %12s %12s %12s\n", "Command", "Count", "Total ms", "Mean ms", "Max ms");
+
+	for (i = 0; i < STATS_MAX_COMMANDS; ++i)
+	{
+		command = &stats.commands[i];
+
+		if (command->count != 0)
+		{
+			fprintf(output, "%-24s %8llu %12.3f %12.3f %12.3f\n", command->name, command->count, command->totalSeconds * 1e3,
+				command->totalSeconds * 1e3 / (double)command->count, command->maxSeconds * 1e3);
+		}
+	}
+}
+
+/*
+// Writes the counters and command latencies to a given file name.
+//
+// [in] fileName - The name of the file
+//
+// Returns error status code.
+*/
+int saveStats(const char* fileName)
+{
+	int   status = 0;
+	FILE* output = fopen(fileName, "w");
+
+	if (output == NULL)
+	{
+		status = errno;
+	}
+	else
+	{
+		writeStats(output);
+
+		if (fclose(output) != 0)
+		{
+			status = errno;
+		}
+	}
+
+	return status;
+}
+#else
+#define STATS_ADD(counter, value)      ((void)0)
+#define STATS_ADD_FILE(counter, file)  ((void)0)
+#define STATS_TIMER(start)
+#define STATS_COMMAND(id, name, start) ((void)0)
+#endif
+
+/*
+// Prints the counters and command latencies, or a notice when they are compiled out.
+*/
+void printStats()
+{
+#ifdef WATCHLIST_STATS
+	writeStats(stdout);
+#else
+	printf("Stats are not compiled into this build; define WATCHLIST_STATS to enable them.\n");
+#endif
+	printf("\n");
+}
+
+/*=========================================================================================================
+// Genres
+//=======================================================================================================*/
+
+/*
+// Table of interned genre names. Each distinct genre is stored once and identified by a small
+// integer id; the names never move once interned.
+*/
+typedef struct GenreTable
+{
+	char**          names;         /* indexed by genre id */
+	int             count;
+	int             capacity;
+	unsigned short* slots;         /* open-addressing hash of genre id + 1, zero when empty */
+	unsigned int    slotCapacity;  /* zero or a power of two */
+	Mutex           lock;          /* held while interning so parser threads can share the table */
+} GenreTable;
+
+#define MAX_GENRE_COUNT 65535
+
+/*
+// The genres of every Movie.
+*/
+static GenreTable genreTable = {NULL, 0, 0, NULL, 0, MUTEX_INITIALIZER};
+
+/*
+// Finds the id of a given genre name, without interning it. The caller holds the lock or no
+// other thread is interning.
+//
+// [in] name - The null-terminated genre name
+// [in] hash - The hash of the genre name
+//
+// Returns the genre id, or -1 if the genre has not been interned.
+*/
+int findGenreId(const char* name, unsigned int hash)
+{
+	int          id   = -1;
+	unsigned int mask = genreTable.slotCapacity - 1;
+	unsigned int slot = 0;
+
+	if (genreTable.slotCapacity != 0)
+	{
+		for (slot = hash & mask; genreTable.slots[slot] != 0; slot = (slot + 1) & mask)
+		{
+			if (strcmp(genreTable.names[genreTable.slots[slot] - 1], name) == 0)
+			{
+				id = genreTable.slots[slot] - 1;
+				break;
+			}
+		}
+	}
+
+	return id;
+}
+
+/*
+// Returns the id of a given genre, interning it if it is new. Safe to call from several threads.
+//
+// [in] genre  - The genre bytes, which need not be null-terminated
+// [in] length - The byte length of the genre (at most MAX_GENRE_LENGTH)
+//
+// Returns the genre id, or -1 on error.
+*/
+int internGenre(const char* genre, int length)
+{
+	int             status                     = 0;
+	int             id                         = -1;
+	char            name[MAX_GENRE_LENGTH + 1] = {0};
+	unsigned int    hash                       = 0;
+	unsigned int    capacity                   = 0;
+	unsigned int    slot                       = 0;
+	unsigned short* slots                      = NULL;
+	char**          names                      = NULL;
+	int             i                          = 0;
+
+	memcpy(name, genre, length);
+	hash = hashTitle(name);
+
+	lockMutex(&genreTable.lock);
+
+	id = findGenreId(name, hash);
+
+	if (id < 0)
+	{
+		if (genreTable.count == MAX_GENRE_COUNT)
+		{
+			status = ERANGE;
+		}
+
+		if (status == 0 && genreTable.count == genreTable.capacity)
+		{
+			names = realloc(genreTable.names, (genreTable.capacity + 16) * sizeof(char*));
+
+			if (names == NULL)
+			{
+				status = ENOMEM;
+			}
+			else
+			{
+				genreTable.names     = names;
+				genreTable.capacity += 16;
+			}
+		}
+
+		/*
+		// Keep the hash at most half full:
+		*/
+		if (status == 0 && (unsigned int)(genreTable.count + 1) * 2 > genreTable.slotCapacity)
+		{
+			capacity = genreTable.slotCapacity == 0 ? 32 : genreTable.slotCapacity * 2;
+			slots    = calloc(capacity, sizeof(unsigned short));
+
+			if (slots == NULL)
+			{
+				status = ENOMEM;
+			}
+			else
+			{
+				for (i = 0; i < genreTable.count; ++i)
+				{
+					for (slot = hashTitle(genreTable.names[i]) & (capacity - 1); slots[slot] != 0; slot = (slot + 1) & (capacity - 1))
+					{
+					}
+
+					slots[slot] = (unsigned short)(i + 1);
+				}
+
+				free(genreTable.slots);
+				genreTable.slots        = slots;
+				genreTable.slotCapacity = capacity;
+			}
+		}
+
+		if (status == 0)
+		{
+			genreTable.names[genreTable.count] = malloc(length + 1);
+
+			if (genreTable.names[genreTable.count] == NULL)
+			{
+				status = ENOMEM;
+			}
+		}
+
+		if (status == 0)
+		{
+			memcpy(genreTable.names[genreTable.count], name, length + 1);
+
+			for (slot = hash & (genreTable.slotCapacity - 1); genreTable.slots[slot] != 0; slot = (slot + 1) & (genreTable.slotCapacity - 1))
+			{
+			}
+
+			id                      = genreTable.count++;
+			genreTable.slots[slot]  = (unsigned short)(id + 1);
+		}
+	}
+
+	unlockMutex(&genreTable.lock);
+
+	if (status != 0)
+	{
+		errno = status;
+	}
+
+	return id;
+}
+
+/*
+// Returns the name of a given genre id.
+//
+// [in] genreId - The genre id
+*/
+const char* getGenreName(unsigned short genreId)
+{
+	return genreId < genreTable.count ? genreTable.names[genreId] : "";
+}
+
+/*
+// Releases the memory held by the genre table.
+*/
+void clearGenreTable()
+{
+	int i = 0;
+
+	for (i = 0; i < genreTable.count; ++i)
+	{
+		free(genreTable.names[i]);
+	}
+
+	free(genreTable.names);
+	free(genreTable.slots);
+
+	genreTable.names        = NULL;
+	genreTable.count        = 0;
+	genreTable.capacity     = 0;
+	genreTable.slots        = NULL;
+	genreTable.slotCapacity = 0;
+}
+
+/*=========================================================================================================
+// Catalogs
+//=======================================================================================================*/
+
+#define MAX_CATALOGS             16
+#define MAX_CATALOG_NAME_LENGTH  31
+
+/*
+// The names of the library files loaded together, indexed by Movie::catalog from 1; catalog 0 is
+// every Movie not loaded that way. Set while loading and read-only afterwards.
+*/
+static char catalogNames[MAX_CATALOGS + 1][MAX_CATALOG_NAME_LENGTH + 1];
+static int  catalogCount = 0;
+
+/*
+// Names the next catalog after a given library file: its base name without the extension, so
+// "regions/us.txt" is "us".
+//
+// [in] fileName - The name of the library file
+//
+// Returns the catalog index, or -1 if there are already MAX_CATALOGS catalogs.
+*/
+int addCatalog(const char* fileName)
+{
+	int         catalog = -1;
+	const char* base    = NULL;
+	const char* dot     = NULL;
+	size_t      length  = 0;
+
+	if (catalogCount < MAX_CATALOGS)
+	{
+		base = strrchr(fileName, '/');
+		base = base != NULL ? base + 1 : fileName;
+#ifdef _WIN32
+		base = strrchr(base, '\\') != NULL ? strrchr(base, '\\') + 1 : base;
+#endif
+		dot    = strrchr(base, '.');
+		length = dot != NULL && dot != base ? (size_t)(dot - base) : strlen(base);
+		length = length < MAX_CATALOG_NAME_LENGTH ? length : MAX_CATALOG_NAME_LENGTH;
+
+		catalog = ++catalogCount;
+
+		memcpy(catalogNames[catalog], base, length);
+		catalogNames[catalog][length] = '\0';
+	}
+
+	return catalog;
+}
+
+/*
+// Returns the name of a given catalog, or NULL for catalog 0 and while there is only one library
+// file, which has no need of a name.
+//
+// [in] catalog - The catalog index
+*/
+const char* getCatalogName(unsigned char catalog)
+{
+	return catalogCount > 1 && catalog >= 1 && catalog <= catalogCount ? catalogNames[catalog] : NULL;
+}
+
+/*=========================================================================================================
+// Movie Nodes
+//=======================================================================================================*/
+
+/*
+// Table of the Movie slabs of every pool, indexed by slab number, so a MovieId can be resolved
+// without knowing its pool. Numbers of released slabs are reused.
+*/
+typedef struct MovieSlabTable
+{
+	Movie*         movies[MOVIE_SLAB_MAX_COUNT];
+	unsigned short freeNumbers[MOVIE_SLAB_MAX_COUNT];
+	int            freeCount;
+	unsigned int   nextNumber;
+	Mutex          lock;  /* held while registering so parser threads can share the table */
+} MovieSlabTable;
+
+static MovieSlabTable movieSlabTable = {{NULL}, {0}, 0, 1, MUTEX_INITIALIZER};
+
+/*
+// Assigns a slab number to a given slab, so the MovieIds of its Movies can be resolved.
+//
+// [in] slab - The Movie slab
+//
+// Returns error status code.
+*/
+int registerMovieSlab(MovieSlab* slab)
+{
+	int status = 0;
+
+	lockMutex(&movieSlabTable.lock);
+
+	if (movieSlabTable.freeCount > 0)
+	{
+		slab->number = movieSlabTable.freeNumbers[--movieSlabTable.freeCount];
+	}
+	else if (movieSlabTable.nextNumber < MOVIE_SLAB_MAX_COUNT)
+	{
+		slab->number = movieSlabTable.nextNumber++;
+	}
+	else
+	{
+		status = ENOMEM;
+	}
+
+	if (status == 0)
+	{
+		movieSlabTable.movies[slab->number] = slab->movies;
+	}
+
+	unlockMutex(&movieSlabTable.lock);
+
+	return status;
+}
+
+/*
+// Releases the slab number of a given slab for reuse.
+//
+// [in] slab - The Movie slab
+*/
+void unregisterMovieSlab(MovieSlab* slab)
+{
+	lockMutex(&movieSlabTable.lock);
+
+	movieSlabTable.movies[slab->number]                    = NULL;
+	movieSlabTable.freeNumbers[movieSlabTable.freeCount++] = (unsigned short)slab->number;
+
+	unlockMutex(&movieSlabTable.lock);
+}
+
+/*
+// Resolves a given MovieId.
+//
+// [in] id - The MovieId
+//
+// Returns the Movie, or NULL for id 0.
+*/
+Movie* getMovie(MovieId id)
+{
+	return id == 0 ? NULL : movieSlabTable.movies[id >> 16] + (id & 0xFFFF);
+}
+
+/*
+// Returns the MovieId of a given Movie, or 0 for NULL.
+//
+// [in] movie - The Movie
+*/
+MovieId getMovieId(const Movie* movie)
+{
+	return movie == NULL ? 0 : movie->id;
+}
+
+/*
+// Copies given string bytes, which need not be null-terminated, into the string arena of a given
+// pool.
+//
+// [in] pool   - The Movie pool
+// [in] string - The string bytes
+// [in] length - The byte length of the string
+//
+// Returns the null-terminated copy, or NULL on error.
+*/
+const char* storeString(MoviePool* pool, const char* string, size_t length)
+{
+	StringChunk* chunk    = pool->strings;
+	size_t       capacity = 0;
+	char*        copy     = NULL;
+
+	if (chunk == NULL || chunk->capacity - chunk->used < length + 1)
+	{
+		capacity = length + 1 > STRING_CHUNK_CAPACITY ? length + 1 : STRING_CHUNK_CAPACITY;
+		chunk    = malloc(sizeof(StringChunk) + capacity);
+
+		if (chunk != NULL)
+		{
+			chunk->next     = pool->strings;
+			chunk->capacity = capacity;
+			chunk->used     = 0;
+			chunk->data     = (char*)(chunk + 1);
+			pool->strings   = chunk;
+		}
+	}
+
+	if (chunk != NULL)
+	{
+		copy = chunk->data + chunk->used;
+		memcpy(copy, string, length);
+		copy[length] = '\0';
+
+		chunk->used += length + 1;
+	}
+
+	return copy;
+}
+
+/*
+// Allocates a zeroed Movie node from a given pool.
+//
+// [in] pool - The Movie pool
+//
+// Returns the allocated Movie, or NULL on error.
+*/
+Movie* allocateMovie(MoviePool* pool)
+{
+	Movie*     movie    = NULL;
+	MovieSlab* slab     = pool->slabs;
+	int        capacity = 0;
+	MovieId    id       = 0;
+
+	if (pool->freeList != NULL)
+	{
+		movie          = pool->freeList;
+		pool->freeList = getMovie(movie->next);
+	}
+	else
+	{
+		if (slab == NULL || slab->used == slab->capacity)
+		{
+			/*
+			// Grow geometrically so small libraries stay small and large ones need few slabs:
+			*/
+			capacity = slab == NULL ? MOVIE_SLAB_MIN_CAPACITY : slab->capacity * 2;
+
+			if (capacity > MOVIE_SLAB_MAX_CAPACITY)
+			{
+				capacity = MOVIE_SLAB_MAX_CAPACITY;
+			}
+
+			slab = malloc(sizeof(MovieSlab) + capacity * sizeof(Movie));
+
+			if (slab != NULL)
+			{
+				slab->capacity = capacity;
+				slab->used     = 0;
+				slab->movies   = (Movie*)(slab + 1);
+
+				if (registerMovieSlab(slab) != 0)
+				{
+					free(slab);
+					slab = NULL;
+				}
+				else
+				{
+					slab->next  = pool->slabs;
+					pool->slabs = slab;
+				}
+			}
+		}
+
+		if (slab != NULL)
+		{
+			movie = &slab->movies[slab->used];
+			id    = slab->number << 16 | (unsigned int)slab->used;
+			++slab->used;
+		}
+	}
+
+	if (movie != NULL)
+	{
+		id = id == 0 ? movie->id : id;
+
+		memset(movie, 0, sizeof(Movie));
+		movie->id = id;
+		++pool->liveCount;
+	}
+
+	return movie;
+}
+
+/*
+// Releases every slab and string of a given pool back to the heap.
+//
+// [in] pool - The Movie pool
+*/
+void destroyMoviePool(MoviePool* pool)
+{
+	MovieSlab*   slab      = pool->slabs;
+	MovieSlab*   next      = NULL;
+	StringChunk* chunk     = pool->strings;
+	StringChunk* nextChunk = NULL;
+
+	while (slab != NULL)
+	{
+		next = slab->next;
+		unregisterMovieSlab(slab);
+		free(slab);
+		slab = next;
+	}
+
+	while (chunk != NULL)
+	{
+		nextChunk = chunk->next;
+		free(chunk);
+		chunk = nextChunk;
+	}
+
+	memset(pool, 0, sizeof(MoviePool));
+}
+
+/*
+// Returns a chain of Movie nodes, linked through Movie::next, to a given pool. Once no nodes
+// remain live the slabs are released in bulk.
+//
+// [in] pool  - The Movie pool
+// [in] head  - The first Movie of the chain
+// [in] tail  - The last Movie of the chain
+// [in] count - The count of Movies in the chain
+*/
+void releaseMovieChain(MoviePool* pool, Movie* head, Movie* tail, int count)
+{
+	if (head != NULL && tail != NULL)
+	{
+		tail->next      = getMovieId(pool->freeList);
+		pool->freeList  = head;
+		pool->liveCount -= count;
+
+		if (pool->liveCount == 0)
+		{
+			destroyMoviePool(pool);
+		}
+	}
+}
+
+/*
+// Returns a single Movie node to a given pool.
+//
+// [in] pool  - The Movie pool
+// [in] movie - The Movie to release
+*/
+void releaseMovie(MoviePool* pool, Movie* movie)
+{
+	releaseMovieChain(pool, movie, movie, 1);
+}
+
+/*
+// Moves every slab, string and free node of one pool into another, leaving the source empty. Nodes
+// allocated from the source remain valid and are owned by the destination afterwards.
+//
+// [in] destination - The Movie pool to merge into
+// [in] source      - The Movie pool to merge from
+*/
+void mergeMoviePool(MoviePool* destination, MoviePool* source)
+{
+	MovieSlab*   last      = source->slabs;
+	Movie*       free      = source->freeList;
+	StringChunk* lastChunk = source->strings;
+
+	if (last != NULL)
+	{
+		while (last->next != NULL)
+		{
+			last = last->next;
+		}
+
+		/*
+		// Keep the destination's current slab at the front so it continues to fill:
+		*/
+		if (destination->slabs == NULL)
+		{
+			destination->slabs = source->slabs;
+		}
+		else
+		{
+			last->next               = destination->slabs->next;
+			destination->slabs->next = source->slabs;
+		}
+	}
+
+	if (lastChunk != NULL)
+	{
+		while (lastChunk->next != NULL)
+		{
+			lastChunk = lastChunk->next;
+		}
+
+		/*
+		// Likewise for the destination's current string chunk:
+		*/
+		if (destination->strings == NULL)
+		{
+			destination->strings = source->strings;
+		}
+		else
+		{
+			lastChunk->next            = destination->strings->next;
+			destination->strings->next = source->strings;
+		}
+	}
+
+	if (free != NULL)
+	{
+		while (free->next != 0)
+		{
+			free = getMovie(free->next);
+		}
+
+		free->next             = getMovieId(destination->freeList);
+		destination->freeList  = source->freeList;
+	}
+
+	destination->liveCount += source->liveCount;
+
+	memset(source, 0, sizeof(MoviePool));
+}
+
+/*
+// Dynamically allocates and creates a Movie of an interned genre from title bytes that need not be
+// null-terminated.
+//
+// [in] pool        - The Movie pool to allocate from
+// [in] title       - The title bytes of the Movie
+// [in] titleLength - The byte length of the title
+// [in] genreId     - The interned genre id of the Movie
+// [in] duration    - The duration of the Movie in hours
+//
+// Returns the created movie, or NULL on error.
+*/
+Movie* createMovieNodeWithGenre(MoviePool* pool, const char* title, int titleLength, int genreId, double duration)
+{
+	int    status = 0;
+	Movie* movie  = NULL;
+
+	if (status == 0)
+	{
+		if (title == NULL || titleLength < 0 || genreId < 0)
+		{
+			status = EINVAL;
+		}
+		else if (titleLength > MAX_TITLE_LENGTH)
+		{
+			status = ERANGE;
+		}
+	}
+
+	if (status == 0)
+	{
+		movie = allocateMovie(pool);
+
+		if (movie == NULL)
+		{
+			status = ENOMEM;
+		}
+		else if ((movie->title = storeString(pool, title, titleLength)) == NULL)
+		{
+			releaseMovie(pool, movie);
+			movie  = NULL;
+			status = ENOMEM;
+		}
+	}
+
+	if (status == 0)
+	{
+		movie->titleLength = (unsigned char)titleLength;
+
+		movie->genreId   = (unsigned short)genreId;
+		movie->duration  = duration;
+		movie->titleHash = hashTitle(movie->title);
+	}
+
+	/*
+	// Parser threads allocate from their own pools and are counted once merged, see Stats:
+	*/
+	if (pool == &moviePool)
+	{
+		STATS_ADD(nodesCreated, status == 0);
+		STATS_ADD(nodeFailures, status != 0);
+	}
+
+	if (status != 0)
+	{
+		errno = status;
+	}
+
+	return movie;
+}
+
+/*
+// Dynamically allocates and creates a Movie from title and genre bytes that need not be
+// null-terminated.
+//
+// [in] pool        - The Movie pool to allocate from
+// [in] title       - The title bytes of the Movie
+// [in] titleLength - The byte length of the title
+// [in] genre       - The genre bytes of the Movie
+// [in] genreLength - The byte length of the genre
+// [in] duration    - The duration of the Movie in hours
+//
+// Returns the created movie, or NULL on error.
+*/
+Movie* createMovieNodeFromBytes(MoviePool* pool, const char* title, int titleLength, const char* genre, int genreLength, double duration)
+{
+	Movie* movie = NULL;
+
+	if (genre == NULL || genreLength < 0)
+	{
+		errno = EINVAL;
+	}
+	else if (genreLength > MAX_GENRE_LENGTH)
+	{
+		errno = ERANGE;
+	}
+	else
+	{
+		movie = createMovieNodeWithGenre(pool, title, titleLength, internGenre(genre, genreLength), duration);
+	}
+
+	return movie;
+}
+
+/*
+// Dynamically allocates and creates a Movie.
+//
+// [in] title	 - The title of the Movie
+// [in] genre    - The genre of the Movie
+// [in] duration - The duration of the Movie in hours
+//
+// Returns the created movie, or NULL on error.
+*/
+Movie* createMovieNode(char* title, char* genre, double duration)
+{
+	Movie* movie = NULL;
+
+	if (title == NULL || genre == NULL)
+	{
+		errno = EINVAL;
+	}
+	else
+	{
+		movie = createMovieNodeFromBytes(&moviePool, title, strlen(title), genre, strlen(genre), duration);
+	}
+
+	return movie;
+}
+
+/*
+// Creates an unlinked copy of a given Movie in a given pool.
+//
+// [in] pool  - The Movie pool to allocate from
+// [in] movie - The Movie to copy
+//
+// Returns the copy, or NULL on error.
+*/
+Movie* copyMovieNode(MoviePool* pool, const Movie* movie)
+{
+	Movie* copy = allocateMovie(pool);
+
+	if (copy == NULL)
+	{
+		errno = ENOMEM;
+	}
+	else
+	{
+		copy->title       = storeString(pool, movie->title, movie->titleLength);
+		copy->titleLength = movie->titleLength;
+		copy->catalog     = movie->catalog;
+		copy->genreId     = movie->genreId;
+		copy->titleHash   = movie->titleHash;
+		copy->duration    = movie->duration;
+
+		if (copy->title == NULL)
+		{
+			releaseMovie(pool, copy);
+			copy  = NULL;
+			errno = ENOMEM;
+		}
+	}
+
+	return copy;
+}
+
+/*
+// Prompts for a string value.
+//
+// [in] buffer     - The input buffer
+// [in] bufferSize - The byte size of the input buffer
+// [in] prompt     - The prompt printed to the user
+// [in] ...        - Additional arguments for a formatted prompt
+//
+// Returns the length of the input string, or EOF on error.
+*/
+int promptFor(char* buffer, int bufferSize, const char* prompt, ...)
+{
+	int newLength      = EOF;
+	int originalLength = 0;
+	int character      = 0;
+
+	if (buffer != NULL && bufferSize > 0)
+	{
+		*buffer = '\0';
+
+		if (prompt != NULL)
+		{
+			va_list alist;
+			va_start(alist, prompt);
+
+			vprintf(prompt, alist);
+
+			va_end(alist);
+		}
+
+		if (fgets(buffer, bufferSize, stdin))
+		{
+			/*
+			// Trim the trailing newlines from the input string:
+			*/
+			originalLength = strlen(buffer);
+
+			newLength = originalLength;
+
+			while (newLength > 0 && buffer[newLength - 1] == '\n')
+			{
+				buffer[--newLength] = '\0';
+			}
+
+			/*
+			// Clear the input buffer if we didn't see a newline:
+			*/
+			if (originalLength == newLength)
+			{
+				while (!feof(stdin))
+				{
+					character = fgetc(stdin);
+
+					if (character <= EOF || character == '\n')
+					{
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	return newLength;
+}
+
+/*
+// Prompts for an integer between a given range (inclusively).
+//
+// [in] minValue - The minimum value allowed
+// [in] maxValue - The maximum value allowed
+// [in] prompt   - The prompt printed to the user
+//
+// Returns the input integer.
+*/
+int promptForInt(int minValue, int maxValue, const char* prompt)
+{
+	char  buffer[100] = {0};
+	char* remainder   = buffer;
+	int   integer     = 0;
+
+	while (true)
+	{
+		promptFor(buffer, _countof(buffer), prompt);
+
+		integer = strtol(buffer, &remainder, 10);
+
+		if (remainder == buffer || *remainder != '\0' || integer < minValue || integer > maxValue)
+		{
+			printf("\n");
+			printf("An integer between %d and %d was expected.\n", minValue, maxValue);
+			printf("\n");
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	return integer;
+}
+
+/*
+// Prompts for a number between a given range (inclusively).
+//
+// [in] minValue - The minimum value allowed
+// [in] maxValue - The maximum value allowed
+// [in] prompt   - The prompt printed to the user
+//
+// Returns the input number.
+*/
+double promptForDouble(double minValue, double maxValue, const char* prompt)
+{
+	char   buffer[100] = {0};
+	char*  remainder   = buffer;
+	double number      = 0.0;
+
+	while (true)
+	{
+		promptFor(buffer, _countof(buffer), prompt);
+
+		number = strtod(buffer, &remainder);
+
+		if (remainder == buffer || *remainder != '\0' || !(number >= minValue && number <= maxValue))
+		{
+			printf("\n");
+			printf("A number between %.2f and %.2f was expected.\n", minValue, maxValue);
+			printf("\n");
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	return number;
+}
+
+/*=========================================================================================================
+// Title Index
+//=======================================================================================================*/
+
+/*
+// Rehashes a given title index into a table of a given capacity.
+//
+// [in] index    - The title index
+// [in] capacity - The new capacity (a power of two)
+//
+// Returns error status code.
+*/
+int resizeTitleIndex(TitleIndex* index, unsigned int capacity)
+{
+	int          status   = 0;
+	Movie**      slots    = NULL;
+	unsigned int mask     = capacity - 1;
+	unsigned int i        = 0;
+	unsigned int slot     = 0;
+
+	if (status == 0)
+	{
+		slots = calloc(capacity, sizeof(Movie*));
+
+		if (slots == NULL)
+		{
+			status = ENOMEM;
+		}
+	}
+
+	if (status == 0)
+	{
+		for (i = 0; i < index->capacity; ++i)
+		{
+			if (index->slots[i] != NULL)
+			{
+				slot = index->slots[i]->titleHash & mask;
+
+				while (slots[slot] != NULL)
+				{
+					slot = (slot + 1) & mask;
+				}
+
+				slots[slot] = index->slots[i];
+			}
+		}
+
+		free(index->slots);
+
+		index->slots    = slots;
+		index->capacity = capacity;
+	}
+
+	return status;
+}
+
+/*
+// Adds a given Movie to a given title index.
+//
+// [in] index - The title index
+// [in] movie - The Movie to add
+//
+// Returns error status code.
+*/
+int addToTitleIndex(TitleIndex* index, Movie* movie)
+{
+	int          status = 0;
+	unsigned int mask   = 0;
+	unsigned int slot   = 0;
+
+	/*
+	// Keep the load factor at or below 70% so probe sequences stay short:
+	*/
+	if ((index->count + 1) * 10 > index->capacity * 7)
+	{
+		status = resizeTitleIndex(index, index->capacity == 0 ? 16 : index->capacity * 2);
+	}
+
+	if (status == 0)
+	{
+		mask = index->capacity - 1;
+		slot = movie->titleHash & mask;
+
+		while (index->slots[slot] != NULL)
+		{
+			slot = (slot + 1) & mask;
+		}
+
+		index->slots[slot] = movie;
+		++index->count;
+	}
+
+	return status;
+}
+
+/*
+// Removes a given Movie from a given title index. Entries following the removed one in its probe
+// sequence are shifted back, so no tombstones are needed.
+//
+// [in] index - The title index
+// [in] movie - The Movie to remove
+*/
+void removeFromTitleIndex(TitleIndex* index, Movie* movie)
+{
+	unsigned int mask = index->capacity - 1;
+	unsigned int slot = 0;
+	unsigned int next = 0;
+	unsigned int home = 0;
+
+	if (index->capacity != 0)
+	{
+		slot = movie->titleHash & mask;
+
+		while (index->slots[slot] != NULL && index->slots[slot] != movie)
+		{
+			slot = (slot + 1) & mask;
+		}
+
+		if (index->slots[slot] == movie)
+		{
+			index->slots[slot] = NULL;
+			--index->count;
+
+			next = (slot + 1) & mask;
+
+			while (index->slots[next] != NULL)
+			{
+				home = index->slots[next]->titleHash & mask;
+
+				/*
+				// Move the entry into the hole unless its home slot lies cyclically in (slot, next]:
+				*/
+				if (((next - home) & mask) >= ((next - slot) & mask))
+				{
+					index->slots[slot] = index->slots[next];
+					index->slots[next] = NULL;
+					slot               = next;
+				}
+
+				next = (next + 1) & mask;
+			}
+		}
+	}
+}
+
+/*
+// Finds a Movie by its given title in a given title index.
+//
+// [in] index - The title index
+// [in] title - The title of the Movie to find
+//
+// Returns the Movie with the given title, or NULL if not found.
+*/
+Movie* findInTitleIndex(const TitleIndex* index, const char* title)
+{
+	Movie*       movie = NULL;
+	unsigned int hash  = 0;
+	unsigned int mask  = index->capacity - 1;
+	unsigned int slot  = 0;
+
+	STATS_ADD(titleLookups, 1);
+
+	if (index->count != 0)
+	{
+		hash = hashTitle(title);
+		slot = hash & mask;
+
+		while (index->slots[slot] != NULL)
+		{
+			STATS_ADD(titleProbes, 1);
+
+			if (index->slots[slot]->titleHash == hash && strcmp(index->slots[slot]->title, title) == 0)
+			{
+				movie = index->slots[slot];
+				STATS_ADD(titleHits, 1);
+				break;
+			}
+
+			slot = (slot + 1) & mask;
+		}
+	}
+
+	return movie;
+}
+
+/*
+// Grows a given title index once so that a given count of additional Movies fits without rehashing.
+//
+// [in] index - The title index
+// [in] count - The count of Movies about to be added
+//
+// Returns error status code.
+*/
+int reserveTitleIndex(TitleIndex* index, int count)
+{
+	int          status   = 0;
+	unsigned int capacity = 16;
+
+	while ((index->count + (unsigned int)count) * 10 > capacity * 7)
+	{
+		capacity *= 2;
+	}
+
+	if (capacity > index->capacity)
+	{
+		status = resizeTitleIndex(index, capacity);
+	}
+
+	return status;
+}
+
+/*
+// Releases the memory held by a given title index.
+//
+// [in] index - The title index
+*/
+void clearTitleIndex(TitleIndex* index)
+{
+	free(index->slots);
+
+	index->slots    = NULL;
+	index->capacity = 0;
+	index->count    = 0;
+}
+
+/*=========================================================================================================
+// Duration Kernels
+//=======================================================================================================*/
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define DURATION_KERNELS_X86
+#endif
+
+#if defined(DURATION_KERNELS_X86) && !defined(_MSC_VER)
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_SSE2
+#define TARGET_AVX2
+#endif
+
+/*
+// Instruction set levels the duration kernels can dispatch to.
+*/
+typedef enum KernelLevel
+{
+	KernelUnknown = 0,
+	KernelScalar  = 1,
+	KernelSse2    = 2,
+	KernelAvx2    = 3
+} KernelLevel;
+
+static KernelLevel kernelLevel = KernelUnknown;
+
+/*
+// Returns the widest instruction set supported by both the processor and the operating system,
+// detected once.
+*/
+KernelLevel getKernelLevel()
+{
+	if (kernelLevel == KernelUnknown)
+	{
+		kernelLevel = KernelScalar;
+
+#if defined(DURATION_KERNELS_X86) && defined(_MSC_VER)
+		{
+			int info[4] = {0};
+
+			__cpuid(info, 1);
+
+			if (info[3] & (1 << 26))
+			{
+				kernelLevel = KernelSse2;
+			}
+
+			/*
+			// AVX2 also needs the OS to save the YMM registers (OSXSAVE + XCR0):
+			*/
+			if ((info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6)
+			{
+				__cpuidex(info, 7, 0);
+
+				if (info[1] & (1 << 5))
+				{
+					kernelLevel = KernelAvx2;
+				}
+			}
+		}
+#elif defined(DURATION_KERNELS_X86)
+		__builtin_cpu_init();
+
+		if (__builtin_cpu_supports("sse2"))
+		{
+			kernelLevel = KernelSse2;
+		}
+
+		if (__builtin_cpu_supports("avx2"))
+		{
+			kernelLevel = KernelAvx2;
+		}
+#endif
+	}
+
+	return kernelLevel;
+}
+
+/*
+// Summary statistics of a set of durations.
+*/
+typedef struct DurationStatistics
+{
+	int    count;
+	double total;    /* hours */
+	double minimum;  /* hours */
+	double maximum;  /* hours */
+	double average;  /* hours */
+} DurationStatistics;
+
+/*
+// Scalar kernels, also used for the tails of the vector kernels.
+*/
+double sumDurationsScalar(const double* durations, int count)
+{
+	double sum = 0.0;
+	int    i   = 0;
+
+	for (i = 0; i < count; ++i)
+	{
+		sum += durations[i];
+	}
+
+	return sum;
+}
+
+void findDurationRangeScalar(const double* durations, int count, double* minimum, double* maximum)
+{
+	int i = 0;
+
+	for (i = 0; i < count; ++i)
+	{
+		*minimum = durations[i] < *minimum ? durations[i] : *minimum;
+		*maximum = durations[i] > *maximum ? durations[i] : *maximum;
+	}
+}
+
+int countDurationsBetweenScalar(const double* durations, int count, double low, double high)
+{
+	int matches = 0;
+	int i       = 0;
+
+	for (i = 0; i < count; ++i)
+	{
+		matches += durations[i] >= low && durations[i] <= high;
+	}
+
+	return matches;
+}
+
+#ifdef DURATION_KERNELS_X86
+
+/*
+// SSE2 kernels: two doubles per register, unrolled over two registers.
+*/
+TARGET_SSE2 double sumDurationsSse2(const double* durations, int count)
+{
+	__m128d first  = _mm_setzero_pd();
+	__m128d second = _mm_setzero_pd();
+	double  lanes[2];
+	int     i      = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		first  = _mm_add_pd(first, _mm_loadu_pd(durations + i));
+		second = _mm_add_pd(second, _mm_loadu_pd(durations + i + 2));
+	}
+
+	_mm_storeu_pd(lanes, _mm_add_pd(first, second));
+
+	return lanes[0] + lanes[1] + sumDurationsScalar(durations + i, count - i);
+}
+
+TARGET_SSE2 void findDurationRangeSse2(const double* durations, int count, double* minimum, double* maximum)
+{
+	__m128d low   = _mm_set1_pd(*minimum);
+	__m128d high  = _mm_set1_pd(*maximum);
+	__m128d value;
+	double  lanes[2];
+	int     i     = 0;
+
+	for (; i + 2 <= count; i += 2)
+	{
+		value = _mm_loadu_pd(durations + i);
+		low   = _mm_min_pd(low, value);
+		high  = _mm_max_pd(high, value);
+	}
+
+	_mm_storeu_pd(lanes, low);
+	*minimum = lanes[0] < lanes[1] ? lanes[0] : lanes[1];
+
+	_mm_storeu_pd(lanes, high);
+	*maximum = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+
+	findDurationRangeScalar(durations + i, count - i, minimum, maximum);
+}
+
+TARGET_SSE2 int countDurationsBetweenSse2(const double* durations, int count, double low, double high)
+{
+	static const int bits[4] = {0, 1, 1, 2};
+
+	__m128d lowBound  = _mm_set1_pd(low);
+	__m128d highBound = _mm_set1_pd(high);
+	__m128d value;
+	int     matches   = 0;
+	int     i         = 0;
+
+	for (; i + 2 <= count; i += 2)
+	{
+		value    = _mm_loadu_pd(durations + i);
+		matches += bits[_mm_movemask_pd(_mm_and_pd(_mm_cmpge_pd(value, lowBound), _mm_cmple_pd(value, highBound)))];
+	}
+
+	return matches + countDurationsBetweenScalar(durations + i, count - i, low, high);
+}
+
+/*
+// AVX2 kernels: four doubles per register, unrolled over four registers for the sum.
+*/
+TARGET_AVX2 double sumDurationsAvx2(const double* durations, int count)
+{
+	__m256d sums[4];
+	double  lanes[4];
+	int     i = 0;
+
+	sums[0] = sums[1] = sums[2] = sums[3] = _mm256_setzero_pd();
+
+	for (; i + 16 <= count; i += 16)
+	{
+		sums[0] = _mm256_add_pd(sums[0], _mm256_loadu_pd(durations + i));
+		sums[1] = _mm256_add_pd(sums[1], _mm256_loadu_pd(durations + i + 4));
+		sums[2] = _mm256_add_pd(sums[2], _mm256_loadu_pd(durations + i + 8));
+		sums[3] = _mm256_add_pd(sums[3], _mm256_loadu_pd(durations + i + 12));
+	}
+
+	_mm256_storeu_pd(lanes, _mm256_add_pd(_mm256_add_pd(sums[0], sums[1]), _mm256_add_pd(sums[2], sums[3])));
+
+	return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + sumDurationsScalar(durations + i, count - i);
+}
+
+TARGET_AVX2 void findDurationRangeAvx2(const double* durations, int count, double* minimum, double* maximum)
+{
+	__m256d low   = _mm256_set1_pd(*minimum);
+	__m256d high  = _mm256_set1_pd(*maximum);
+	__m256d value;
+	double  lanes[4];
+	int     i     = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		value = _mm256_loadu_pd(durations + i);
+		low   = _mm256_min_pd(low, value);
+		high  = _mm256_max_pd(high, value);
+	}
+
+	_mm256_storeu_pd(lanes, low);
+	findDurationRangeScalar(lanes, 4, minimum, maximum);
+
+	_mm256_storeu_pd(lanes, high);
+	findDurationRangeScalar(lanes, 4, minimum, maximum);
+
+	findDurationRangeScalar(durations + i, count - i, minimum, maximum);
+}
+
+TARGET_AVX2 int countDurationsBetweenAvx2(const double* durations, int count, double low, double high)
+{
+	static const int bits[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+
+	__m256d lowBound  = _mm256_set1_pd(low);
+	__m256d highBound = _mm256_set1_pd(high);
+	__m256d value;
+	int     matches   = 0;
+	int     i         = 0;
+
+	for (; i + 4 <= count; i += 4)
+	{
+		value    = _mm256_loadu_pd(durations + i);
+		matches += bits[_mm256_movemask_pd(_mm256_and_pd(_mm256_cmp_pd(value, lowBound, _CMP_GE_OQ),
+		                                                 _mm256_cmp_pd(value, highBound, _CMP_LE_OQ)))];
+	}
+
+	return matches + countDurationsBetweenScalar(durations + i, count - i, low, high);
+}
+
+#endif
+
+/*
+// Sums a given array of durations.
+//
+// [in] durations - The durations in hours
+// [in] count     - The count of durations
+//
+// Returns the sum in hours.
+*/
+double sumDurations(const double* durations, int count)
+{
+	double sum = 0.0;
+
+	switch (getKernelLevel())
+	{
+#ifdef DURATION_KERNELS_X86
+		case KernelAvx2: sum = sumDurationsAvx2(durations, count); break;
+		case KernelSse2: sum = sumDurationsSse2(durations, count); break;
+#endif
+		default:         sum = sumDurationsScalar(durations, count);
+	}
+
+	return sum;
+}
+
+/*
+// Finds the shortest and longest of a given array of durations.
+//
+// [in]  durations - The durations in hours
+// [in]  count     - The count of durations (at least 1)
+// [out] minimum   - The shortest duration
+// [out] maximum   - The longest duration
+*/
+void findDurationRange(const double* durations, int count, double* minimum, double* maximum)
+{
+	*minimum = durations[0];
+	*maximum = durations[0];
+
+	switch (getKernelLevel())
+	{
+#ifdef DURATION_KERNELS_X86
+		case KernelAvx2: findDurationRangeAvx2(durations, count, minimum, maximum); break;
+		case KernelSse2: findDurationRangeSse2(durations, count, minimum, maximum); break;
+#endif
+		default:         findDurationRangeScalar(durations, count, minimum, maximum);
+	}
+}
+
+/*
+// Counts the durations of a given array within a given range (inclusively).
+//
+// [in] durations - The durations in hours
+// [in] count     - The count of durations
+// [in] low       - The lower bound in hours
+// [in] high      - The upper bound in hours
+//
+// Returns the count of durations within the range.
+*/
+int countDurationsBetween(const double* durations, int count, double low, double high)
+{
+	int matches = 0;
+
+	switch (getKernelLevel())
+	{
+#ifdef DURATION_KERNELS_X86
+		case KernelAvx2: matches = countDurationsBetweenAvx2(durations, count, low, high); break;
+		case KernelSse2: matches = countDurationsBetweenSse2(durations, count, low, high); break;
+#endif
+		default:         matches = countDurationsBetweenScalar(durations, count, low, high);
+	}
+
+	return matches;
+}
+
+/*=========================================================================================================
+// Movie Columns
+//=======================================================================================================*/
+
+/*
+// Releases the columns cached for a given linked list of Movies.
+//
+// [in] list - The linked list of Movies
+*/
+void clearMovieColumns(MovieList* list)
+{
+	if (list->columns != NULL)
+	{
+		free(list->columns->durations);
+		free(list->columns->genreIds);
+		free(list->columns->titleOffsets);
+		free(list->columns->titles);
+		free(list->columns);
+
+		list->columns = NULL;
+	}
+}
+
+/*
+// Builds the structure-of-arrays copy of a given linked list of Movies.
+//
+// [in]  list    - The linked list of Movies
+// [out] columns - The zeroed columns to fill
+//
+// Returns error status code.
+*/
+int buildMovieColumns(MovieList* list, MovieColumns* columns)
+{
+	int          status     = 0;
+	size_t       titleBytes = 0;
+	size_t       offset     = 0;
+	size_t       length     = 0;
+	Movie*       itr        = NULL;
+	int          i          = 0;
+
+	if (status == 0)
+	{
+		for (itr = list->head; itr != NULL; itr = getMovie(itr->next))
+		{
+			titleBytes += strlen(itr->title) + 1;
+		}
+
+		columns->count        = list->count;
+		columns->revision     = list->revision;
+		columns->durations    = malloc(list->count * sizeof(double) + 1);
+		columns->genreIds     = malloc(list->count * sizeof(unsigned int) + 1);
+		columns->titleOffsets = malloc(list->count * sizeof(unsigned int) + 1);
+		columns->titles       = malloc(titleBytes + 1);
+
+		if (columns->durations == NULL || columns->genreIds == NULL || columns->titleOffsets == NULL || columns->titles == NULL)
+		{
+			status = ENOMEM;
+		}
+	}
+
+	if (status == 0)
+	{
+		for (itr = list->head, i = 0; itr != NULL; itr = getMovie(itr->next), ++i)
+		{
+			length = strlen(itr->title) + 1;
+			memcpy(columns->titles + offset, itr->title, length);
+			columns->titleOffsets[i] = (unsigned int)offset;
+			offset += length;
+
+			columns->genreIds[i]  = itr->genreId;
+			columns->durations[i] = itr->duration;
+		}
+	}
+
+	return status;
+}
+
+/*
+// Returns the up-to-date columns of a given linked list of Movies, rebuilding them if the list
+// changed since they were last built. The columns remain valid until the list next changes.
+//
+// [in] list - The linked list of Movies
+//
+// Returns the columns, or NULL on error.
+*/
+MovieColumns* getMovieColumns(MovieList* list)
+{
+	int status = 0;
+
+	if (list->columns != NULL && list->columns->revision != list->revision)
+	{
+		clearMovieColumns(list);
+	}
+
+	if (list->columns == NULL)
+	{
+		list->columns = calloc(1, sizeof(MovieColumns));
+
+		if (list->columns == NULL)
+		{
+			status = ENOMEM;
+		}
+		else
+		{
+			status = buildMovieColumns(list, list->columns);
+		}
+
+		if (status != 0)
+		{
+			clearMovieColumns(list);
+			errno = status;
+		}
+	}
+
+	return list->columns;
+}
+
+/*
+// Computes the total duration in hours of given columns.
+//
+// [in] columns - The Movie columns
+//
+// Returns the computed duration.
+*/
+double computeColumnsDuration(const MovieColumns* columns)
+{
+	return sumDurations(columns->durations, columns->count);
+}
+
+/*
+// Computes summary statistics of the durations of given columns.
+//
+// [in]  columns    - The Movie columns
+// [out] statistics - The duration statistics
+*/
+void computeColumnsStatistics(const MovieColumns* columns, DurationStatistics* statistics)
+{
+	memset(statistics, 0, sizeof(DurationStatistics));
+
+	statistics->count = columns->count;
+
+	if (columns->count > 0)
+	{
+		statistics->total   = sumDurations(columns->durations, columns->count);
+		statistics->average = statistics->total / columns->count;
+
+		findDurationRange(columns->durations, columns->count, &statistics->minimum, &statistics->maximum);
+	}
+}
+
+/*=========================================================================================================
+// Title Search Index
+//=======================================================================================================*/
+
+#define SEARCH_OVERFLOW_LIMIT 1024  /* titles added after a build before it is rebuilt */
+#define SEARCH_PAGE_SIZE      20
+
+/*
+// Compares at most a given count of characters of two titles, ignoring case.
+//
+// [in] left   - The first title
+// [in] right  - The second title
+// [in] length - The maximum count of characters to compare
+//
+// Returns less than, equal to or greater than zero as left sorts before, with or after right.
+*/
+int compareTitlesIgnoreCase(const char* left, const char* right, size_t length)
+{
+	int    difference = 0;
+	size_t i          = 0;
+
+	for (i = 0; i < length; ++i)
+	{
+		difference = toupper((unsigned char)left[i]) - toupper((unsigned char)right[i]);
+
+		if (difference != 0 || left[i] == '\0')
+		{
+			break;
+		}
+	}
+
+	return difference;
+}
+
+/*
+// Determines whether a given title contains a given text, ignoring case.
+//
+// [in] title - The title
+// [in] text  - The text to find
+//
+// Returns true if the title contains the text.
+*/
+bool containsIgnoreCase(const char* title, const char* text)
+{
+	bool   contains = false;
+	size_t length   = strlen(text);
+
+	for (; !contains && *title != '\0'; ++title)
+	{
+		contains = compareTitlesIgnoreCase(title, text, length) == 0;
+	}
+
+	return contains || length == 0;
+}
+
+/*
+// Extracts the distinct trigrams of a given title, ignoring case, in ascending order.
+//
+// [in]  title    - The title
+// [out] trigrams - The trigrams, with room for strlen(title) entries
+//
+// Returns the count of trigrams.
+*/
+int getTrigrams(const char* title, unsigned int* trigrams)
+{
+	int          count = 0;
+	int          i     = 0;
+	int          j     = 0;
+	unsigned int key   = 0;
+
+	for (i = 0; title[i] != '\0' && title[i + 1] != '\0' && title[i + 2] != '\0'; ++i)
+	{
+		key = ((unsigned int)toupper((unsigned char)title[i]) << 16) |
+		      ((unsigned int)toupper((unsigned char)title[i + 1]) << 8) |
+		      (unsigned int)toupper((unsigned char)title[i + 2]);
+
+		/*
+		// Titles are short, so an insertion sort keeps the keys ordered and distinct:
+		*/
+		for (j = count; j > 0 && trigrams[j - 1] > key; --j)
+		{
+		}
+
+		if (j == 0 || trigrams[j - 1] != key)
+		{
+			memmove(trigrams + j + 1, trigrams + j, (count - j) * sizeof(unsigned int));
+			trigrams[j] = key;
+			++count;
+		}
+	}
+
+	return count;
+}
+
+/*
+// qsort comparators for the search index build.
+*/
+static const char* sortingTitles = NULL;
+
+int compareSortedTitles(const void* left, const void* right)
+{
+	return compareTitlesIgnoreCase(sortingTitles + *(const unsigned int*)left, sortingTitles + *(const unsigned int*)right, (size_t)-1);
+}
+
+int comparePostings(const void* left, const void* right)
+{
+	uint64_t a = *(const uint64_t*)left;
+	uint64_t b = *(const uint64_t*)right;
+
+	return a < b ? -1 : a > b;
+}
+
+/*
+// Releases a given title search index.
+//
+// [in] index - The title search index
+*/
+void clearTitleSearchIndex(TitleSearchIndex* index)
+{
+	int i = 0;
+
+	if (index != NULL)
+	{
+		for (i = 0; i < index->extraCount; ++i)
+		{
+			free(index->extra[i]);
+		}
+
+		free(index->titles);
+		free(index->sorted);
+		free(index->trigramKeys);
+		free(index->trigramStarts);
+		free(index->postings);
+		free(index->extra);
+		free(index);
+	}
+}
+
+/*
+// Builds a title search index over the titles of a given linked list of Movies: the titles sorted
+// ignoring case for prefix search, and an inverted index from each trigram to the titles
+// containing it for partial and fuzzy search. The index keeps its own copy of the titles, and
+// matches are resolved through the list's title index, so Movies that later leave the list are
+// skipped.
+//
+// [in] list - The linked list of Movies
+//
+// Returns the built index, or NULL on error.
+*/
+TitleSearchIndex* buildTitleSearchIndex(MovieList* list)
+{
+	int               status     = 0;
+	TitleSearchIndex* index      = NULL;
+	uint64_t*         pairs      = NULL;
+	size_t            pairCount  = 0;
+	size_t            titleBytes = 0;
+	size_t            offset     = 0;
+	size_t            length     = 0;
+	unsigned int      trigrams[MAX_TITLE_LENGTH + 1];
+	int               trigramCount = 0;
+	Movie*            itr        = NULL;
+	int               i          = 0;
+	int               j          = 0;
+	size_t            k          = 0;
+
+	if (status == 0)
+	{
+		index = calloc(1, sizeof(TitleSearchIndex));
+
+		for (itr = list->head; itr != NULL; itr = getMovie(itr->next))
+		{
+			length      = strlen(itr->title);
+			titleBytes += length + 1;
+			pairCount  += length > 2 ? length - 2 : 0;
+		}
+
+		if (index != NULL)
+		{
+			index->count    = list->count;
+			index->titles   = malloc(titleBytes + 1);
+			index->sorted   = malloc(list->count * sizeof(unsigned int) + 1);
+			index->postings = malloc(pairCount * sizeof(unsigned int) + 1);
+		}
+
+		pairs = malloc(pairCount * sizeof(uint64_t) + 1);
+
+		if (index == NULL || index->titles == NULL || index->sorted == NULL || index->postings == NULL || pairs == NULL)
+		{
+			status = ENOMEM;
+		}
+	}
+
+	if (status == 0)
+	{
+		for (itr = list->head, i = 0; itr != NULL; itr = getMovie(itr->next), ++i)
+		{
+			length = strlen(itr->title) + 1;
+			memcpy(index->titles + offset, itr->title, length);
+			index->sorted[i] = (unsigned int)offset;
+			offset += length;
+		}
+
+		sortingTitles = index->titles;
+		qsort(index->sorted, index->count, sizeof(unsigned int), compareSortedTitles);
+
+		/*
+		// Gather (trigram, position) pairs and sort them into posting lists:
+		*/
+		for (i = 0, pairCount = 0; i < index->count; ++i)
+		{
+			trigramCount = getTrigrams(index->titles + index->sorted[i], trigrams);
+
+			for (j = 0; j < trigramCount; ++j)
+			{
+				pairs[pairCount++] = ((uint64_t)trigrams[j] << 32) | (uint64_t)i;
+			}
+		}
+
+		qsort(pairs, pairCount, sizeof(uint64_t), comparePostings);
+
+		for (k = 0; k < pairCount; ++k)
+		{
+			if (k == 0 || (pairs[k] >> 32) != (pairs[k - 1] >> 32))
+			{
+				++index->trigramCount;
+			}
+		}
+
+		index->trigramKeys   = malloc(index->trigramCount * sizeof(unsigned int) + 1);
+		index->trigramStarts = malloc((index->trigramCount + 1) * sizeof(unsigned int));
+
+		if (index->trigramKeys == NULL || index->trigramStarts == NULL)
+		{
+			status = ENOMEM;
+		}
+	}
+
+	if (status == 0)
+	{
+		for (k = 0, i = 0; k < pairCount; ++k)
+		{
+			if (k == 0 || (pairs[k] >> 32) != (pairs[k - 1] >> 32))
+			{
+				index->trigramKeys[i]   = (unsigned int)(pairs[k] >> 32);
+				index->trigramStarts[i] = (unsigned int)k;
+				++i;
+			}
+
+			index->postings[k] = (unsigned int)pairs[k];
+		}
+
+		index->trigramStarts[index->trigramCount] = (unsigned int)pairCount;
+	}
+
+	if (status != 0)
+	{
+		clearTitleSearchIndex(index);
+		index = NULL;
+		errno = status;
+	}
+
+	free(pairs);
+
+	return index;
+}
+
+/*
+// Finds the first sorted position whose title is not before a given prefix, ignoring case.
+//
+// [in] index  - The title search index
+// [in] prefix - The prefix
+//
+// Returns the sorted position.
+*/
+int findPrefixPosition(const TitleSearchIndex* index, const char* prefix)
+{
+	int    low    = 0;
+	int    high   = index->count;
+	int    middle = 0;
+	size_t length = strlen(prefix);
+
+	while (low < high)
+	{
+		middle = low + (high - low) / 2;
+
+		if (compareTitlesIgnoreCase(index->titles + index->sorted[middle], prefix, length) < 0)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	return low;
+}
+
+/*
+// Determines whether a given title is already covered by a given title search index.
+//
+// [in] index - The title search index
+// [in] title - The title
+//
+// Returns true if the title is in the index.
+*/
+bool isTitleSearchable(const TitleSearchIndex* index, const char* title)
+{
+	bool found    = false;
+	int  position = findPrefixPosition(index, title);
+	int  i        = 0;
+
+	/*
+	// Titles equal ignoring case sort together, so check each of them for an exact match:
+	*/
+	for (; !found && position < index->count && compareTitlesIgnoreCase(index->titles + index->sorted[position], title, (size_t)-1) == 0; ++position)
+	{
+		found = strcmp(index->titles + index->sorted[position], title) == 0;
+	}
+
+	for (i = 0; !found && i < index->extraCount; ++i)
+	{
+		found = strcmp(index->extra[i], title) == 0;
+	}
+
+	return found;
+}
+
+/*
+// Records a Movie joining the list of a given title search index. Titles the index does not know
+// are kept on a short overflow list that queries scan directly.
+//
+// [in] index - The title search index
+// [in] movie - The Movie
+//
+// Returns error status code.
+*/
+int noteSearchTitle(TitleSearchIndex* index, Movie* movie)
+{
+	int    status = 0;
+	char** extra  = NULL;
+
+	if (!isTitleSearchable(index, movie->title))
+	{
+		if (index->extraCount == index->extraCapacity)
+		{
+			extra = realloc(index->extra, (index->extraCapacity + 16) * sizeof(char*));
+
+			if (extra == NULL)
+			{
+				status = ENOMEM;
+			}
+			else
+			{
+				index->extra          = extra;
+				index->extraCapacity += 16;
+			}
+		}
+
+		if (status == 0)
+		{
+			index->extra[index->extraCount] = malloc(strlen(movie->title) + 1);
+
+			if (index->extra[index->extraCount] == NULL)
+			{
+				status = ENOMEM;
+			}
+			else
+			{
+				strcpy(index->extra[index->extraCount++], movie->title);
+			}
+		}
+	}
+
+	return status;
+}
+
+/*
+// Appends the Movie with a given title to a given result array if it is still in a given list.
+//
+// [in]     list    - The linked list of Movies searched
+// [in]     title   - The matched title
+// [in,out] results - The result array, with room for the match
+// [in,out] count   - The count of results
+*/
+void addSearchResult(MovieList* list, const char* title, Movie** results, int* count)
+{
+	Movie* movie = findInTitleIndex(&list->titleIndex, title);
+
+	if (movie != NULL)
+	{
+		results[(*count)++] = movie;
+	}
+}
+
+/*
+// Determines whether the search index of a given list is built and up to date, in which case
+// searching the list does not modify it.
+//
+// [in] list - The linked list of Movies
+*/
+bool isTitleSearchIndexCurrent(const MovieList* list)
+{
+	return list->searchIndex != NULL && !list->searchIndex->stale && list->searchIndex->extraCount <= SEARCH_OVERFLOW_LIMIT;
+}
+
+/*
+// Returns the up-to-date search index of a given list, building it if needed and rebuilding it
+// once too many titles have joined since the last build.
+//
+// [in] list - The linked list of Movies
+//
+// Returns the title search index, or NULL on error.
+*/
+TitleSearchIndex* getTitleSearchIndex(MovieList* list)
+{
+	if (list->searchIndex != NULL && !isTitleSearchIndexCurrent(list))
+	{
+		clearTitleSearchIndex(list->searchIndex);
+		list->searchIndex = NULL;
+	}
+
+	if (list->searchIndex == NULL)
+	{
+		list->searchIndex = buildTitleSearchIndex(list);
+	}
+
+	return list->searchIndex;
+}
+
+/*
+// Finds the Movies of a given list whose titles start with a given prefix, ignoring case, in title
+// order.
+//
+// [in]  list    - The linked list of Movies
+// [in]  prefix  - The prefix
+// [out] results - The matching Movies, to be freed by the caller
+//
+// Returns the count of matches, or -1 on error.
+*/
+int searchByPrefix(MovieList* list, const char* prefix, Movie*** results)
+{
+	int               count    = -1;
+	TitleSearchIndex* index    = getTitleSearchIndex(list);
+	int               position = 0;
+	int               end      = 0;
+	size_t            length   = strlen(prefix);
+	int               i        = 0;
+
+	*results = NULL;
+
+	if (index != NULL)
+	{
+		position = findPrefixPosition(index, prefix);
+
+		for (end = position; end < index->count && compareTitlesIgnoreCase(index->titles + index->sorted[end], prefix, length) == 0; ++end)
+		{
+		}
+
+		*results = malloc((end - position + index->extraCount) * sizeof(Movie*) + 1);
+
+		if (*results == NULL)
+		{
+			errno = ENOMEM;
+		}
+		else
+		{
+			for (count = 0; position < end; ++position)
+			{
+				addSearchResult(list, index->titles + index->sorted[position], *results, &count);
+			}
+
+			for (i = 0; i < index->extraCount; ++i)
+			{
+				if (compareTitlesIgnoreCase(index->extra[i], prefix, length) == 0)
+				{
+					addSearchResult(list, index->extra[i], *results, &count);
+				}
+			}
+		}
+	}
+
+	return count;
+}
+
+/*
+// A candidate of a fuzzy search.
+*/
+typedef struct SearchCandidate
+{
+	int  position;   /* sorted position */
+	int  score;      /* shared trigrams */
+	bool substring;  /* the title contains the query */
+} SearchCandidate;
+
+int compareCandidates(const void* left, const void* right)
+{
+	const SearchCandidate* a = left;
+	const SearchCandidate* b = right;
+
+	if (a->substring != b->substring)
+	{
+		return a->substring ? -1 : 1;
+	}
+
+	if (a->score != b->score)
+	{
+		return b->score - a->score;
+	}
+
+	return a->position - b->position;
+}
+
+/*
+// Finds the Movies of a given list whose titles contain a given text or share at least half of its
+// trigrams, ignoring case. Titles containing the text come first, then the closest matches.
+//
+// [in]  list    - The linked list of Movies
+// [in]  text    - The partial title
+// [out] results - The matching Movies, to be freed by the caller
+//
+// Returns the count of matches, or -1 on error.
+*/
+int searchByPartialTitle(MovieList* list, const char* text, Movie*** results)
+{
+	int               status         = 0;
+	int               count          = -1;
+	TitleSearchIndex* index          = getTitleSearchIndex(list);
+	unsigned int      trigrams[100];
+	int               trigramCount   = 0;
+	unsigned short*   scores         = NULL;
+	SearchCandidate*  candidates     = NULL;
+	int               candidateCount = 0;
+	int               threshold      = 0;
+	int               low            = 0;
+	int               high           = 0;
+	int               middle         = 0;
+	unsigned int      k              = 0;
+	int               i              = 0;
+
+	*results = NULL;
+
+	if (status == 0)
+	{
+		if (index == NULL)
+		{
+			status = errno;
+		}
+		else if (strlen(text) >= _countof(trigrams))
+		{
+			status = ERANGE;
+		}
+	}
+
+	if (status == 0)
+	{
+		scores     = calloc(index->count + 1, sizeof(unsigned short));
+		candidates = malloc((index->count + 1) * sizeof(SearchCandidate));
+		*results   = malloc((index->count + index->extraCount) * sizeof(Movie*) + 1);
+
+		if (scores == NULL || candidates == NULL || *results == NULL)
+		{
+			status = ENOMEM;
+		}
+	}
+
+	if (status == 0)
+	{
+		trigramCount = getTrigrams(text, trigrams);
+		threshold    = (trigramCount + 1) / 2;
+
+		if (trigramCount == 0)
+		{
+			/*
+			// Too short for trigrams, so fall back to an exact substring scan:
+			*/
+			for (i = 0; i < index->count; ++i)
+			{
+				if (containsIgnoreCase(index->titles + index->sorted[i], text))
+				{
+					candidates[candidateCount].position  = i;
+					candidates[candidateCount].score     = 0;
+					candidates[candidateCount].substring = true;
+					++candidateCount;
+				}
+			}
+		}
+		else
+		{
+			for (i = 0; i < trigramCount; ++i)
+			{
+				for (low = 0, high = index->trigramCount; low < high; )
+				{
+					middle = low + (high - low) / 2;
+
+					if (index->trigramKeys[middle] < trigrams[i])
+					{
+						low = middle + 1;
+					}
+					else
+					{
+						high = middle;
+					}
+				}
+
+				if (low < index->trigramCount && index->trigramKeys[low] == trigrams[i])
+				{
+					for (k = index->trigramStarts[low]; k < index->trigramStarts[low + 1]; ++k)
+					{
+						if (++scores[index->postings[k]] == threshold)
+						{
+							candidates[candidateCount].position = (int)index->postings[k];
+							++candidateCount;
+						}
+					}
+				}
+			}
+
+			for (i = 0; i < candidateCount; ++i)
+			{
+				candidates[i].score     = scores[candidates[i].position];
+				candidates[i].substring = containsIgnoreCase(index->titles + index->sorted[candidates[i].position], text);
+			}
+		}
+
+		qsort(candidates, candidateCount, sizeof(SearchCandidate), compareCandidates);
+
+		for (count = 0, i = 0; i < candidateCount; ++i)
+		{
+			addSearchResult(list, index->titles + index->sorted[candidates[i].position], *results, &count);
+		}
+
+		for (i = 0; i < index->extraCount; ++i)
+		{
+			if (containsIgnoreCase(index->extra[i], text))
+			{
+				addSearchResult(list, index->extra[i], *results, &count);
+			}
+		}
+	}
+
+	if (status != 0)
+	{
+		free(*results);
+		*results = NULL;
+		count    = -1;
+		errno    = status;
+	}
+
+	free(scores);
+	free(candidates);
+
+	return count;
+}
+
+/*=========================================================================================================
+// Order Index
+//=======================================================================================================*/
+
+/*
+// Every list keeps its Movies in a randomized binary search tree keyed by position, threaded
+// through the Movie nodes themselves. Each node records the size of its subtree, so the Movie at a
+// position and the position of a Movie are both found in expected O(log n) steps. The tree is
+// balanced by choosing roots at random in proportion to subtree sizes (Martinez & Roura), which
+// needs no stored priorities and accepts any balanced tree as a valid starting point.
+*/
+
+/*
+// Returns a pseudo-random value for a balancing decision between two given order subtrees. It is
+// a hash of the MovieIds and sizes involved rather than a shared generator, so threads editing
+// separate lists (server sessions) share no state.
+//
+// [in] left  - The first MovieId
+// [in] right - The second MovieId
+// [in] size  - The combined subtree size
+*/
+uint32_t getOrderRandom(MovieId left, MovieId right, unsigned int size)
+{
+	uint32_t hash = left * 0x9E3779B1u ^ right * 0x85EBCA77u ^ size * 0xC2B2AE3Du;
+
+	hash ^= hash >> 16;
+	hash *= 0x85EBCA6Bu;
+	hash ^= hash >> 13;
+	hash *= 0xC2B2AE35u;
+	hash ^= hash >> 16;
+
+	return hash;
+}
+
+/*
+// Returns the count of Movies in the order subtree rooted at a given Movie.
+//
+// [in] root - The subtree root, or 0
+*/
+unsigned int getOrderSize(MovieId root)
+{
+	return root == 0 ? 0 : getMovie(root)->orderSize;
+}
+
+/*
+// Recomputes the subtree size of a given order node and re-parents its children.
+//
+// [in] movie - The order node
+*/
+void updateOrderNode(Movie* movie)
+{
+	movie->orderSize = 1 + getOrderSize(movie->orderLeft) + getOrderSize(movie->orderRight);
+
+	if (movie->orderLeft != 0)
+	{
+		getMovie(movie->orderLeft)->orderParent = movie->id;
+	}
+
+	if (movie->orderRight != 0)
+	{
+		getMovie(movie->orderRight)->orderParent = movie->id;
+	}
+}
+
+/*
+// Splits a given order subtree into its first count Movies and the rest.
+//
+// [in]  root  - The subtree root, or 0
+// [in]  count - The count of Movies to split off the front
+// [out] left  - The first count Movies
+// [out] right - The rest
+*/
+void splitOrder(MovieId root, unsigned int count, MovieId* left, MovieId* right)
+{
+	Movie* node = getMovie(root);
+
+	if (node == NULL)
+	{
+		*left  = 0;
+		*right = 0;
+	}
+	else if (count <= getOrderSize(node->orderLeft))
+	{
+		splitOrder(node->orderLeft, count, left, &node->orderLeft);
+		updateOrderNode(node);
+		*right = root;
+	}
+	else
+	{
+		splitOrder(node->orderRight, count - getOrderSize(node->orderLeft) - 1, &node->orderRight, right);
+		updateOrderNode(node);
+		*left = root;
+	}
+}
+
+/*
+// Joins two order subtrees, all of whose Movies in left precede those in right.
+//
+// [in] left  - The first subtree, or 0
+// [in] right - The second subtree, or 0
+//
+// Returns the root of the joined subtree.
+*/
+MovieId joinOrder(MovieId left, MovieId right)
+{
+	MovieId root      = 0;
+	Movie*  leftNode  = getMovie(left);
+	Movie*  rightNode = getMovie(right);
+
+	if (leftNode == NULL || rightNode == NULL)
+	{
+		root = leftNode == NULL ? right : left;
+	}
+	else if (getOrderRandom(left, right, leftNode->orderSize + rightNode->orderSize) % (leftNode->orderSize + rightNode->orderSize) <
+	         leftNode->orderSize)
+	{
+		leftNode->orderRight = joinOrder(leftNode->orderRight, right);
+		updateOrderNode(leftNode);
+		root = left;
+	}
+	else
+	{
+		rightNode->orderLeft = joinOrder(left, rightNode->orderLeft);
+		updateOrderNode(rightNode);
+		root = right;
+	}
+
+	return root;
+}
+
+/*
+// Inserts a given Movie into an order subtree at a given position (zero-based).
+//
+// [in] root     - The subtree root, or 0
+// [in] movie    - The Movie to insert, not in any tree
+// [in] position - The position at which to insert
+//
+// Returns the root of the subtree.
+*/
+MovieId insertIntoOrder(MovieId root, Movie* movie, unsigned int position)
+{
+	Movie*       node     = getMovie(root);
+	unsigned int leftSize = 0;
+
+	if (node == NULL || getOrderRandom(root, movie->id, node->orderSize + 1) % (node->orderSize + 1) == 0)
+	{
+		splitOrder(root, position, &movie->orderLeft, &movie->orderRight);
+		updateOrderNode(movie);
+		root = movie->id;
+	}
+	else
+	{
+		leftSize = getOrderSize(node->orderLeft);
+
+		if (position <= leftSize)
+		{
+			node->orderLeft = insertIntoOrder(node->orderLeft, movie, position);
+		}
+		else
+		{
+			node->orderRight = insertIntoOrder(node->orderRight, movie, position - leftSize - 1);
+		}
+
+		updateOrderNode(node);
+	}
+
+	return root;
+}
+
+/*
+// Adds a given Movie to the order index of a given linked list of Movies at a given position.
+//
+// [in] list     - The linked list of Movies
+// [in] movie    - The Movie to add
+// [in] position - The position at which to add
+*/
+void addToOrderIndex(MovieList* list, Movie* movie, int position)
+{
+	movie->orderParent = 0;
+	list->orderRoot    = getMovie(insertIntoOrder(getMovieId(list->orderRoot), movie, (unsigned int)position));
+
+	list->orderRoot->orderParent = 0;
+}
+
+/*
+// Removes a given Movie from the order index of a given linked list of Movies.
+//
+// [in] list  - The linked list of Movies
+// [in] movie - The Movie to remove
+*/
+void removeFromOrderIndex(MovieList* list, Movie* movie)
+{
+	Movie* parent  = getMovie(movie->orderParent);
+	Movie* subtree = getMovie(joinOrder(movie->orderLeft, movie->orderRight));
+	Movie* itr     = NULL;
+
+	if (subtree != NULL)
+	{
+		subtree->orderParent = movie->orderParent;
+	}
+
+	if (parent == NULL)
+	{
+		list->orderRoot = subtree;
+	}
+	else if (parent->orderLeft == movie->id)
+	{
+		parent->orderLeft = getMovieId(subtree);
+	}
+	else
+	{
+		parent->orderRight = getMovieId(subtree);
+	}
+
+	for (itr = parent; itr != NULL; itr = getMovie(itr->orderParent))
+	{
+		--itr->orderSize;
+	}
+
+	movie->orderParent = 0;
+	movie->orderLeft   = 0;
+	movie->orderRight  = 0;
+	movie->orderSize   = 0;
+}
+
+/*
+// Builds a perfectly balanced order subtree over the next count Movies of a linked chain.
+//
+// [in,out] cursor - The first Movie to take, advanced past the last one taken
+// [in]     count  - The count of Movies to take
+//
+// Returns the subtree root.
+*/
+Movie* buildOrderSubtree(Movie** cursor, unsigned int count)
+{
+	Movie* root = NULL;
+	Movie* left = NULL;
+
+	if (count > 0)
+	{
+		left    = buildOrderSubtree(cursor, count / 2);
+		root    = *cursor;
+		*cursor = getMovie(root->next);
+
+		root->orderLeft  = getMovieId(left);
+		root->orderRight = getMovieId(buildOrderSubtree(cursor, count - count / 2 - 1));
+		updateOrderNode(root);
+	}
+
+	return root;
+}
+
+/*
+// Rebuilds the predecessor links and order index of a given linked list of Movies in O(n), for
+// lists linked directly by the loaders.
+//
+// [in] list - The linked list of Movies
+*/
+void buildOrderIndex(MovieList* list)
+{
+	Movie*  cursor = list->head;
+	MovieId prev   = 0;
+	Movie*  itr    = NULL;
+
+	for (itr = list->head; itr != NULL; prev = itr->id, itr = getMovie(itr->next))
+	{
+		itr->prev = prev;
+	}
+
+	list->orderRoot = buildOrderSubtree(&cursor, (unsigned int)list->count);
+
+	if (list->orderRoot != NULL)
+	{
+		list->orderRoot->orderParent = 0;
+	}
+}
+
+/*
+// Determines the position (zero-based) of a given Movie in a given linked list of Movies.
+//
+// [in] list  - The linked list of Movies
+// [in] movie - The Movie
+//
+// Returns the position, or -1 if the Movie is not in the list.
+*/
+int getMoviePosition(MovieList* list, Movie* movie)
+{
+	int    position = -1;
+	Movie* itr      = movie;
+	Movie* parent   = NULL;
+
+	STATS_ADD(orderWalks, 1);
+
+	if (list != NULL && movie != NULL && movie->orderSize > 0)
+	{
+		position = (int)getOrderSize(movie->orderLeft);
+
+		for (; (parent = getMovie(itr->orderParent)) != NULL; itr = parent)
+		{
+			STATS_ADD(orderSteps, 1);
+
+			if (parent->orderRight == itr->id)
+			{
+				position += (int)getOrderSize(parent->orderLeft) + 1;
+			}
+		}
+
+		if (itr != list->orderRoot)
+		{
+			position = -1;
+		}
+	}
+
+	return position;
+}
+
+/*
+// Finds the Movie at a given position (zero-based) in a given linked list of Movies.
+//
+// [in] list     - The linked list of Movies
+// [in] position - The position
+//
+// Returns the Movie, or NULL if the position is out of range.
+*/
+Movie* getMovieAt(MovieList* list, int position)
+{
+	Movie*       itr      = NULL;
+	unsigned int leftSize = 0;
+
+	STATS_ADD(orderWalks, 1);
+
+	if (list != NULL && position >= 0 && position < list->count)
+	{
+		itr = list->orderRoot;
+
+		while (itr != NULL && (leftSize = getOrderSize(itr->orderLeft)) != (unsigned int)position)
+		{
+			STATS_ADD(orderSteps, 1);
+
+			if ((unsigned int)position < leftSize)
+			{
+				itr = getMovie(itr->orderLeft);
+			}
+			else
+			{
+				position -= (int)leftSize + 1;
+				itr       = getMovie(itr->orderRight);
+			}
+		}
+	}
+
+	return itr;
+}
+
+/*=========================================================================================================
+// Journal
+//=======================================================================================================*/
+
+#define JOURNAL_FILE_SUFFIX        ".journal"
+#define JOURNAL_MAGIC              "MWLJ"
+#define JOURNAL_VERSION            1
+#define JOURNAL_COMPACT_MIN_RECORDS 64  /* below this a save only syncs the journal */
+#define JOURNAL_PENDING_SUFFIX     ".pending"
+#define SNAPSHOT_TEMP_SUFFIX       ".tmp"
+
+/*
+// An append-only log of the changes made to a watchlist since it was last written to its file,
+// see startJournal. The journal begins with a header identifying that file's contents, followed by
+// one record per change:
+//
+//   I <position> <duration>\n<title>\n<genre>\n   insertion at a position (zero-based)
+//   R\n<title>\n                                   removal
+//   S\n<title>\n                                   swap with the next Movie
+//   O\n<order>\n                                   sort, see sortMovieList
+//
+// Records are flushed as they are written, so a crash loses at most the record being written,
+// which replayJournal then ignores.
+//
+// A watchlist file is rewritten in the background, see startBackgroundSave. Until it is in place
+// the journal of the new contents is kept under JOURNAL_PENDING_SUFFIX and every record is also
+// appended to the journal of the old contents, so whichever file a crash leaves behind has a
+// journal that brings it up to date.
+*/
+typedef struct BackgroundSave
+{
+	Thread thread;
+	char*  fileName;
+	char*  data;    /* the whole new contents of the file */
+	size_t size;
+	int    status;  /* of the write, once the thread has finished */
+} BackgroundSave;
+
+typedef struct Journal
+{
+	FILE*           file;
+	char*           snapshotName;  /* the watchlist file the journal applies to */
+	int             records;       /* written since the file was */
+	FILE*           previous;      /* the journal of the contents being replaced, or NULL */
+	BackgroundSave* save;          /* the write of the file still running, or NULL */
+} Journal;
+
+/*
+// Flushes a given file and asks the OS to write it through to disk.
+//
+// [in] file - The file
+//
+// Returns error status code.
+*/
+int syncFile(FILE* file)
+{
+	int status = 0;
+
+	if (fflush(file) != 0)
+	{
+		status = errno;
+	}
+#ifdef _WIN32
+	else if (_commit(_fileno(file)) != 0)
+#else
+	else if (fsync(fileno(file)) != 0)
+#endif
+	{
+		status = errno;
+	}
+
+	return status;
+}
+
+/*
+// Returns the name of a given file with a given suffix appended, to be freed by the caller, or
+// NULL on error.
+//
+// [in] fileName - The name of the file
+// [in] suffix   - The suffix
+*/
+char* getSuffixedName(const char* fileName, const char* suffix)
+{
+	char* name = malloc(strlen(fileName) + strlen(suffix) + 1);
+
+	if (name == NULL)
+	{
+		errno = ENOMEM;
+	}
+	else
+	{
+		strcat(strcpy(name, fileName), suffix);
+	}
+
+	return name;
+}
+
+/*
+// Returns the name of the journal of a given watchlist file, to be freed by the caller, or NULL on
+// error.
+//
+// [in] fileName - The name of the watchlist file
+*/
+char* getJournalName(const char* fileName)
+{
+	return getSuffixedName(fileName, JOURNAL_FILE_SUFFIX);
+}
+
+/*
+// Returns the name of the journal of the contents a given watchlist file is being rewritten with,
+// to be freed by the caller, or NULL on error.
+//
+// [in] fileName - The name of the watchlist file
+*/
+char* getPendingJournalName(const char* fileName)
+{
+	return getSuffixedName(fileName, JOURNAL_FILE_SUFFIX JOURNAL_PENDING_SUFFIX);
+}
+
+#ifndef _WIN32
+/*
+// Asks the OS to write the directory entry of a given file through to disk, which makes a rename
+// of the file durable. Not every file system can sync a directory, so this is best effort.
+//
+// [in] fileName - The name of the file
+*/
+void syncDirectoryOf(const char* fileName)
+{
+	char* directory = getSuffixedName(fileName, "");
+	char* slash     = directory != NULL ? strrchr(directory, '/') : NULL;
+	int   handle    = -1;
+
+	if (directory != NULL)
+	{
+		if (slash == directory)
+		{
+			slash[1] = '\0';
+		}
+		else if (slash != NULL)
+		{
+			slash[0] = '\0';
+		}
+
+		handle = open(slash != NULL ? directory : ".", O_RDONLY);
+
+		if (handle >= 0)
+		{
+			fsync(handle);
+			close(handle);
+		}
+
+		free(directory);
+	}
+}
+#endif
+
+/*
+// Renames a given file, replacing any file that has the new name.
+//
+// [in] from - The name of the file
+// [in] to   - The new name
+//
+// Returns error status code.
+*/
+int moveFile(const char* from, const char* to)
+{
+	int status = 0;
+
+#ifdef _WIN32
+	if (!MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+	{
+		status = EIO;
+	}
+#else
+	if (rename(from, to) != 0)
+	{
+		status = errno;
+	}
+	else
+	{
+		syncDirectoryOf(to);
+	}
+#endif
+
+	return status;
+}
+
+/*
+// Replaces the contents of a given file atomically: they are written to and synced in a
+// temporary file that is then renamed over the file, so a crash leaves either the old contents
+// or the new ones.
+//
+// [in] fileName - The name of the file
+// [in] data     - The new contents
+// [in] size     - The size of the new contents
+//
+// Returns error status code.
+*/
+int replaceFile(const char* fileName, const char* data, size_t size)
+{
+	int   status = 0;
+	char* temp   = getSuffixedName(fileName, SNAPSHOT_TEMP_SUFFIX);
+	FILE* output = NULL;
+
+	if (temp == NULL)
+	{
+		status = ENOMEM;
+	}
+
+	if (status == 0)
+	{
+		output = fopen(temp, "wb");
+
+		if (output == NULL)
+		{
+			status = errno;
+		}
+	}
+
+	if (status == 0 && fwrite(data, 1, size, output) != size)
+	{
+		status = EIO;
+	}
+
+	if (status == 0)
+	{
+		status = syncFile(output);
+	}
+
+	if (output != NULL && fclose(output) != 0 && status == 0)
+	{
+		status = EIO;
+	}
+
+	if (status == 0)
+	{
+		status = moveFile(temp, fileName);
+	}
+
+	if (status != 0 && output != NULL)
+	{
+		remove(temp);
+	}
+
+	free(temp);
+
+	return status;
+}
+
+/*
+// Thread function writing a file in the background, see startBackgroundSave.
+//
+// [in] save - The BackgroundSave
+*/
+void runBackgroundSave(void* save)
+{
+	BackgroundSave* background = save;
+
+	background->status = replaceFile(background->fileName, background->data, background->size);
+}
+
+/*
+// Waits for the background write of a given journal's watchlist file, if any, and moves the
+// journal of the new contents into place once the file is. On error the file keeps its old
+// contents, which the journal they had still brings up to date, and the given journal must be
+// closed.
+//
+// [in] journal - The journal
+//
+// Returns error status code.
+*/
+int finishJournalSave(Journal* journal)
+{
+	int   status  = 0;
+	char* pending = NULL;
+	char* name    = NULL;
+
+	if (journal->save != NULL)
+	{
+		joinThread(&journal->save->thread);
+
+		status  = journal->save->status;
+		pending = getPendingJournalName(journal->snapshotName);
+		name    = getJournalName(journal->snapshotName);
+
+		if (status == 0 && (pending == NULL || name == NULL))
+		{
+			status = ENOMEM;
+		}
+
+		/*
+		// The old journal is replaced by the rename, and some platforms cannot rename open files:
+		*/
+		if (journal->previous != NULL)
+		{
+			fclose(journal->previous);
+			journal->previous = NULL;
+		}
+
+		if (status == 0)
+		{
+			STATS_ADD_FILE(bytesWritten, journal->file);
+			fclose(journal->file);
+
+			status        = moveFile(pending, name);
+			journal->file = status == 0 ? fopen(name, "a") : NULL;
+
+			if (status == 0 && journal->file == NULL)
+			{
+				status = errno;
+			}
+		}
+		else if (journal->save->status != 0 && pending != NULL)
+		{
+			remove(pending);
+		}
+
+		free(journal->save->fileName);
+		free(journal->save->data);
+		free(journal->save);
+		journal->save = NULL;
+	}
+
+	free(pending);
+	free(name);
+
+	return status;
+}
+
+/*
+// Appends one record to a given journal, and to the journal of the contents being replaced while
+// the watchlist file is rewritten.
+//
+// [in] journal - The journal
+// [in] format  - The printf format of the record
+// [in] ...     - The values of the record
+*/
+void writeJournalRecord(Journal* journal, const char* format, ...)
+{
+	va_list arguments;
+	FILE*   files[2] = {journal->file, journal->previous};
+	int     i        = 0;
+
+	for (i = 0; i < 2; ++i)
+	{
+		if (files[i] != NULL)
+		{
+			va_start(arguments, format);
+			vfprintf(files[i], format, arguments);
+			va_end(arguments);
+
+			fflush(files[i]);
+		}
+	}
+
+	++journal->records;
+}
+
+/*
+// Appends the insertion of a given Movie at a given position to a given journal.
+//
+// [in] journal  - The journal, or NULL
+// [in] movie    - The inserted Movie
+// [in] position - The position it was inserted at
+*/
+void journalInsert(Journal* journal, Movie* movie, int position)
+{
+	if (journal != NULL)
+	{
+		writeJournalRecord(journal, "I %d %.17g\n%s\n%s\n", position, movie->duration, movie->title, getGenreName(movie->genreId));
+	}
+}
+
+/*
+// Appends a removal ('R') or a swap with the next Movie ('S') of a given Movie to a given journal.
+//
+// [in] journal - The journal, or NULL
+// [in] type    - The record type
+// [in] movie   - The Movie
+*/
+void journalChange(Journal* journal, char type, Movie* movie)
+{
+	if (journal != NULL)
+	{
+		writeJournalRecord(journal, "%c\n%s\n", type, movie->title);
+	}
+}
+
+/*
+// Appends the sorting of the list in a given order to a given journal. Sorting is deterministic, so
+// replaying the record reproduces the order.
+//
+// [in] journal - The journal, or NULL
+// [in] order   - The order
+*/
+void journalSort(Journal* journal, MovieOrder order)
+{
+	if (journal != NULL)
+	{
+		writeJournalRecord(journal, "O\n%s\n", movieOrderNames[order]);
+	}
+}
+
+/*
+// Closes and releases a given journal, first waiting for any background write of its file.
+//
+// [in] journal - The journal, or NULL
+*/
+void closeJournal(Journal* journal)
+{
+	if (journal != NULL)
+	{
+		finishJournalSave(journal);
+
+		if (journal->previous != NULL)
+		{
+			fclose(journal->previous);
+		}
+
+		if (journal->file != NULL)
+		{
+			STATS_ADD_FILE(bytesWritten, journal->file);
+			fclose(journal->file);
+		}
+
+		free(journal->snapshotName);
+		free(journal);
+	}
+}
+
+/*=========================================================================================================
+// Sorted Views
+//=======================================================================================================*/
+
+/*
+// Finds the order with a given name, see movieOrderNames.
+//
+// [in] name - The name of the order
+//
+// Returns the order, or -1 if there is none by that name.
+*/
+int findMovieOrder(const char* name)
+{
+	int order = MOVIE_ORDER_COUNT - 1;
+
+	while (order >= 0 && strcmp(name, movieOrderNames[order]) != 0)
+	{
+		--order;
+	}
+
+	return order;
+}
+
+/*
+// Prompts for and returns an order to sort or view Movies in.
+*/
+MovieOrder promptForMovieOrder()
+{
+	MovieOrder order = ByTitle;
+
+	printf("1) By title\n");
+	printf("2) By duration\n");
+	printf("3) By genre\n");
+	printf("\n");
+
+	order = (MovieOrder)(promptForInt(1, MOVIE_ORDER_COUNT, "Enter an order: ") - 1);
+	printf("\n");
+
+	return order;
+}
+
+/*
+// Compares two Movies in a given order.
+//
+// [in] left  - The first Movie
+// [in] right - The second Movie
+// [in] order - The order
+//
+// Returns less than, equal to or greater than zero as left sorts before, with or after right.
+*/
+int compareMovies(const Movie* left, const Movie* right, MovieOrder order)
+{
+	int difference = 0;
+
+	if (order == ByDuration)
+	{
+		difference = (left->duration > right->duration) - (left->duration < right->duration);
+	}
+	else if (order == ByGenre && left->genreId != right->genreId)
+	{
+		difference = strcmp(getGenreName(left->genreId), getGenreName(right->genreId));
+	}
+
+	if (difference == 0)
+	{
+		difference = compareTitlesIgnoreCase(left->title, right->title, (size_t)-1);
+	}
+
+	return difference != 0 ? difference : strcmp(left->title, right->title);
+}
+
+/*
+// Sorts a given linked list of Movies in place in a given order with a bottom-up merge sort, which
+// takes O(n log n) comparisons, relinks the nodes rather than moving them and allocates nothing.
+// The sort is stable, and watchlists journal it, see journalSort.
+//
+// [in] list  - The linked list of Movies
+// [in] order - The order
+//
+// Returns error status code.
+*/
+int sortMovieList(MovieList* list, MovieOrder order)
+{
+	int    status    = 0;
+	Movie* head      = NULL;
+	Movie* tail      = NULL;
+	Movie* left      = NULL;
+	Movie* right     = NULL;
+	Movie* take      = NULL;
+	int    width     = 0;
+	int    leftSize  = 0;
+	int    rightSize = 0;
+	int    merges    = 0;
+
+	if (list == NULL || (int)order < 0 || (int)order >= MOVIE_ORDER_COUNT)
+	{
+		status = EINVAL;
+	}
+
+	if (status == 0 && list->count > 1)
+	{
+		head = list->head;
+
+		/*
+		// Merge runs of width 1, 2, 4, ... until a single pass finds one run:
+		*/
+		for (width = 1, merges = 2; merges > 1; width *= 2)
+		{
+			left   = head;
+			head   = NULL;
+			tail   = NULL;
+			merges = 0;
+
+			while (left != NULL)
+			{
+				++merges;
+
+				for (right = left, leftSize = 0; right != NULL && leftSize < width; ++leftSize)
+				{
+					right = getMovie(right->next);
+				}
+
+				for (rightSize = width; leftSize > 0 || (rightSize > 0 && right != NULL); tail = take)
+				{
+					/*
+					// Equal Movies are taken from the left run first to keep the sort stable:
+					*/
+					if (leftSize == 0 || (rightSize > 0 && right != NULL && compareMovies(right, left, order) < 0))
+					{
+						take  = right;
+						right = getMovie(right->next);
+						--rightSize;
+					}
+					else
+					{
+						take = left;
+						left = getMovie(left->next);
+						--leftSize;
+					}
+
+					if (tail == NULL)
+					{
+						head = take;
+					}
+					else
+					{
+						tail->next = take->id;
+					}
+				}
+
+				left = right;
+			}
+
+			tail->next = 0;
+		}
+
+		list->head = head;
+		list->tail = tail;
+		buildOrderIndex(list);
+	}
+
+	if (status == 0)
+	{
+		journalSort(list->journal, order);
+		++list->revision;
+	}
+
+	return status;
+}
+
+/*
+// Sorts given Movies in a given order with a bottom-up merge sort.
+//
+// [in,out] movies  - The Movies
+// [in]     scratch - Room for as many Movies
+// [in]     count   - The count of Movies
+// [in]     order   - The order
+*/
+void sortMovies(Movie** movies, Movie** scratch, int count, MovieOrder order)
+{
+	Movie** from  = movies;
+	Movie** to    = scratch;
+	Movie** swap  = NULL;
+	int     width = 0;
+	int     start = 0;
+	int     i     = 0;
+	int     j     = 0;
+	int     k     = 0;
+	int     mid   = 0;
+	int     end   = 0;
+
+	for (width = 1; width < count; width *= 2)
+	{
+		for (start = 0; start < count; start += 2 * width)
+		{
+			mid = start + width < count ? start + width : count;
+			end = start + 2 * width < count ? start + 2 * width : count;
+
+			for (i = start, j = mid, k = start; k < end; ++k)
+			{
+				to[k] = i < mid && (j == end || compareMovies(from[j], from[i], order) >= 0) ? from[i++] : from[j++];
+			}
+		}
+
+		swap = from;
+		from = to;
+		to   = swap;
+	}
+
+	if (from != movies)
+	{
+		memcpy(movies, from, count * sizeof(Movie*));
+	}
+}
+
+/*
+// Releases the sorted view of a given linked list of Movies in a given order.
+//
+// [in] list  - The linked list of Movies
+// [in] order - The order
+*/
+void clearSortedView(MovieList* list, MovieOrder order)
+{
+	if (list->sortedViews[order] != NULL)
+	{
+		free(list->sortedViews[order]->movies);
+		free(list->sortedViews[order]);
+
+		list->sortedViews[order] = NULL;
+	}
+}
+
+/*
+// Returns the up-to-date view of a given linked list of Movies in a given order, rebuilding it if
+// the list changed since it was last built. The list itself keeps its order. The view remains valid
+// until the list next changes, so repeated queries on an unchanged list cost no sorting.
+//
+// [in] list  - The linked list of Movies
+// [in] order - The order
+//
+// Returns the sorted view, or NULL on error.
+*/
+SortedView* getSortedView(MovieList* list, MovieOrder order)
+{
+	int         status  = 0;
+	SortedView* view    = list->sortedViews[order];
+	Movie**     scratch = NULL;
+	Movie*      itr     = NULL;
+	int         i       = 0;
+
+	if (view != NULL && view->revision != list->revision)
+	{
+		clearSortedView(list, order);
+		view = NULL;
+	}
+
+	if (view == NULL)
+	{
+		view    = calloc(1, sizeof(SortedView));
+		scratch = malloc(list->count * sizeof(Movie*) + 1);
+
+		if (view == NULL || scratch == NULL || (view->movies = malloc(list->count * sizeof(Movie*) + 1)) == NULL)
+		{
+			status = ENOMEM;
+		}
+		else
+		{
+			for (itr = list->head, i = 0; itr != NULL; itr = getMovie(itr->next), ++i)
+			{
+				view->movies[i] = itr;
+			}
+
+			view->count    = list->count;
+			view->revision = list->revision;
+
+			sortMovies(view->movies, scratch, view->count, order);
+		}
+
+		list->sortedViews[order] = view;
+
+		if (status != 0)
+		{
+			clearSortedView(list, order);
+			view  = NULL;
+			errno = status;
+		}
+
+		free(scratch);
+	}
+
+	return view;
+}
+
+/*
+// Finds the first position in a given duration view of a Movie longer than, or at least as long as,
+// a given duration.
+//
+// [in] view     - The view in duration order
+// [in] duration - The duration in hours
+// [in] longer   - Whether to find the first Movie longer than the duration rather than at least
+//                 as long
+//
+// Returns the position, view->count if there is no such Movie.
+*/
+int findDurationPosition(const SortedView* view, double duration, bool longer)
+{
+	int low  = 0;
+	int high = view->count;
+	int mid  = 0;
+
+	while (low < high)
+	{
+		mid = low + (high - low) / 2;
+
+		if (longer ? view->movies[mid]->duration <= duration : view->movies[mid]->duration < duration)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+
+	return low;
+}
+
+/*
+// Finds the Movies of a given list whose durations lie within a given range (inclusive) through
+// its duration view, in O(log n) plus the matches.
+//
+// [in]  list  - The linked list of Movies
+// [in]  low   - The shortest duration in hours
+// [in]  high  - The longest duration in hours
+// [out] first - The matches, shortest first, which remain valid until the list next changes
+//
+// Returns the count of matches, or -1 on error.
+*/
+int findDurationsBetween(MovieList* list, double low, double high, Movie*** first)
+{
+	int         count = -1;
+	int         start = 0;
+	SortedView* view  = getSortedView(list, ByDuration);
+
+	if (view != NULL)
+	{
+		start  = findDurationPosition(view, low, false);
+		count  = high < low ? 0 : findDurationPosition(view, high, true) - start;
+		*first = view->movies + start;
+	}
+
+	return count;
+}
+
+/*=========================================================================================================
+// Ingest Reports
+//=======================================================================================================*/
+
+#define INGEST_REPORT_EXAMPLES 10
+#define INGEST_EXAMPLE_LENGTH  40
+#define MAX_DURATION_HOURS     1000.0
+
+/*
+// Kinds of library records dropped while loading.
+*/
+typedef enum IngestIssue
+{
+	DuplicateTitle     = 0,  /* a title already read, of which the first record is kept */
+	MalformedRecord    = 1,  /* a missing, empty or over-long line, or a duration that is no number */
+	DurationOutOfRange = 2   /* not above zero and at most MAX_DURATION_HOURS */
+} IngestIssue;
+
+#define INGEST_ISSUE_COUNT 3
+
+/*
+// One dropped record shown in an ingest report.
+*/
+typedef struct IngestExample
+{
+	int         record;  /* zero-based number of the record in the file */
+	IngestIssue issue;
+	char        title[INGEST_EXAMPLE_LENGTH + 1];
+} IngestExample;
+
+/*
+// What loading a library dropped. Parse workers fill one report each, with records numbered from
+// firstRecord, that are merged in file order, see mergeIngestReport.
+*/
+typedef struct IngestReport
+{
+	int           firstRecord;                     /* zero-based number of the first record read */
+	int           records;                         /* read, including dropped ones */
+	bool          binary;                          /* of a binary file, whose records have no lines */
+	int           counts[INGEST_ISSUE_COUNT];
+	IngestExample examples[INGEST_REPORT_EXAMPLES];  /* the first records dropped by each stage */
+	int           exampleCount;
+	int*          dropped;     /* numbers of the records dropped while parsing, ascending */
+	int           droppedCount;
+	int           droppedCapacity;
+} IngestReport;
+
+/*
+// Records a dropped record in a given report.
+//
+// [in] report - The ingest report
+// [in] issue  - Why the record was dropped
+// [in] record - The zero-based number of the record in the file
+// [in] title  - The title bytes of the record, which need not be null-terminated
+// [in] length - The byte length of the title
+// [in] parsed - Whether the record was dropped while parsing, so that no Movie was created for it
+//
+// Returns error status code.
+*/
+int noteIngestIssue(IngestReport* report, IngestIssue issue, int record, const char* title, size_t length, bool parsed)
+{
+	int            status  = 0;
+	int*           grown   = NULL;
+	IngestExample* example = NULL;
+
+	++report->counts[issue];
+
+	if (report->exampleCount < INGEST_REPORT_EXAMPLES)
+	{
+		example        = &report->examples[report->exampleCount++];
+		example->record = record;
+		example->issue  = issue;
+		length          = length < INGEST_EXAMPLE_LENGTH ? length : INGEST_EXAMPLE_LENGTH;
+
+		memcpy(example->title, title, length);
+		example->title[length] = '\0';
+	}
+
+	if (parsed && report->droppedCount == report->droppedCapacity)
+	{
+		grown = realloc(report->dropped, (report->droppedCapacity + 256) * sizeof(int));
+
+		if (grown == NULL)
+		{
+			status = ENOMEM;
+		}
+		else
+		{
+			report->dropped          = grown;
+			report->droppedCapacity += 256;
+		}
+	}
+
+	if (parsed && status == 0)
+	{
+		report->dropped[report->droppedCount++] = record;
+	}
+
+	return status;
+}
+
+/*
+// Appends a given report, of records that follow those of another, to that other report and
+// releases it.
+//
+// [in,out] destination - The ingest report
+// [in,out] source      - The report of the following records, emptied
+//
+// Returns error status code.
+*/
+int mergeIngestReport(IngestReport* destination, IngestReport* source)
+{
+	int  status = 0;
+	int* grown  = NULL;
+	int  i      = 0;
+
+	for (i = 0; i < INGEST_ISSUE_COUNT; ++i)
+	{
+		destination->counts[i] += source->counts[i];
+	}
+
+	for (i = 0; i < source->exampleCount && destination->exampleCount < INGEST_REPORT_EXAMPLES; ++i)
+	{
+		destination->examples[destination->exampleCount++] = source->examples[i];
+	}
+
+	if (destination->droppedCount + source->droppedCount > destination->droppedCapacity)
+	{
+		grown  = realloc(destination->dropped, (destination->droppedCount + source->droppedCount) * sizeof(int));
+		status = grown == NULL ? ENOMEM : 0;
+
+		if (grown != NULL)
+		{
+			destination->dropped         = grown;
+			destination->droppedCapacity = destination->droppedCount + source->droppedCount;
+		}
+	}
+
+	if (status == 0)
+	{
+		memcpy(destination->dropped + destination->droppedCount, source->dropped, source->droppedCount * sizeof(int));
+		destination->droppedCount += source->droppedCount;
+		destination->records      += source->records;
+	}
+
+	free(source->dropped);
+	memset(source, 0, sizeof(IngestReport));
+
+	return status;
+}
+
+/*
+// Returns the zero-based record number in the file of the Movie at a given position of the list
+// parsed with a given report, for positions visited in ascending order.
+//
+// [in]     report   - The ingest report
+// [in]     position - The position of the Movie in the list as parsed
+// [in,out] cursor   - The count of dropped records before the position, 0 before the first call
+*/
+int getIngestRecord(const IngestReport* report, int position, int* cursor)
+{
+	while (*cursor < report->droppedCount && report->dropped[*cursor] <= position + *cursor)
+	{
+		++*cursor;
+	}
+
+	return report->firstRecord + position + *cursor;
+}
+
+/*
+// Prints a given report if any records were dropped.
+//
+// [in] report   - The ingest report
+// [in] fileName - The name of the library file
+// [in] output   - The stream to print to
+*/
+void printIngestReport(const IngestReport* report, const char* fileName, FILE* output)
+{
+	static const char* issues[INGEST_ISSUE_COUNT] = {"duplicate title", "malformed record", "duration out of range"};
+	int                i                          = 0;
+
+	if (report->counts[DuplicateTitle] + report->counts[MalformedRecord] + report->counts[DurationOutOfRange] > 0)
+	{
+		fprintf(output, "%s: %d records read, dropped %d duplicate titles, %d malformed records and %d durations out of range.\n",
+			fileName, report->records, report->counts[DuplicateTitle], report->counts[MalformedRecord], report->counts[DurationOutOfRange]);
+
+		for (i = 0; i < report->exampleCount; ++i)
+		{
+			fprintf(output, "  %s %d: %s: %s\n", report->binary ? "Record" : "Line",
+			        report->binary ? report->examples[i].record + 1 : report->examples[i].record * 3 + 1,
+			        issues[report->examples[i].issue], report->examples[i].title);
+		}
+	}
+}
+
+/*
+// Releases what a given report holds.
+//
+// [in] report - The ingest report
+*/
+void clearIngestReport(IngestReport* report)
+{
+	free(report->dropped);
+	memset(report, 0, sizeof(IngestReport));
+}
+
+/*=========================================================================================================
+// Movie List
+//=======================================================================================================*/
+
+/*
+// Initializes a given linked list of Movies to be empty.
+//
+// [in] list - The linked list of Movies
+*/
+void initMovieList(MovieList* list)
+{
+	memset(list, 0, sizeof(MovieList));
+}
+
+/*
+// Returns the pool the Movies of a given linked list of Movies are released to.
+//
+// [in] list - The linked list of Movies
+*/
+MoviePool* getListPool(MovieList* list)
+{
+	return list->pool != NULL ? list->pool : &moviePool;
+}
+
+/*
+// Adds a given value to a running sum using Neumaier's compensated summation, which keeps long
+// series of additions and removals from drifting.
+//
+// [in] sum          - The running sum
+// [in] compensation - The running compensation term, added to the sum when it is read
+// [in] value        - The value to add
+*/
+void addCompensated(double* sum, double* compensation, double value)
+{
+	double total = *sum + value;
+
+	if (fabs(*sum) >= fabs(value))
+	{
+		*compensation += (*sum - total) + value;
+	}
+	else
+	{
+		*compensation += (value - total) + *sum;
+	}
+
+	*sum = total;
+}
+
+/*
+// Adds a given duration (negative when a Movie leaves) to the running total of a given linked list
+// of Movies.
+//
+// [in] list     - The linked list of Movies
+// [in] duration - The duration in hours to add
+*/
+void trackDuration(MovieList* list, double duration)
+{
+	addCompensated(&list->duration, &list->durationCompensation, duration);
+}
+
+/*
+// Adds a given Movie to the end of its genre bucket in a given linked list of Movies.
+//
+// [in] list  - The linked list of Movies
+// [in] movie - The Movie to add
+//
+// Returns error status code.
+*/
+int addToGenreIndex(MovieList* list, Movie* movie)
+{
+	int          status  = 0;
+	GenreBucket* buckets = NULL;
+	GenreBucket* bucket  = NULL;
+	int          count   = 0;
+
+	if (movie->genreId >= list->genreBucketCount)
+	{
+		count   = genreTable.count > movie->genreId ? genreTable.count : movie->genreId + 1;
+		buckets = realloc(list->genreBuckets, count * sizeof(GenreBucket));
+
+		if (buckets == NULL)
+		{
+			status = ENOMEM;
+		}
+		else
+		{
+			memset(buckets + list->genreBucketCount, 0, (count - list->genreBucketCount) * sizeof(GenreBucket));
+
+			list->genreBuckets     = buckets;
+			list->genreBucketCount = count;
+		}
+	}
+
+	if (status == 0)
+	{
+		bucket = &list->genreBuckets[movie->genreId];
+
+		movie->genrePrev = getMovieId(bucket->tail);
+		movie->genreNext = 0;
+
+		if (bucket->tail == NULL)
+		{
+			bucket->head = movie;
+		}
+		else
+		{
+			bucket->tail->genreNext = getMovieId(movie);
+		}
+
+		bucket->tail = movie;
+		++bucket->count;
+
+		addCompensated(&bucket->duration, &bucket->durationCompensation, movie->duration);
+	}
+
+	return status;
+}
+
+/*
+// Removes a given Movie from its genre bucket in a given linked list of Movies.
+//
+// [in] list  - The linked list of Movies
+// [in] movie - The Movie to remove
+*/
+void removeFromGenreIndex(MovieList* list, Movie* movie)
+{
+	GenreBucket* bucket = &list->genreBuckets[movie->genreId];
+
+	if (movie->genrePrev == 0)
+	{
+		bucket->head = getMovie(movie->genreNext);
+	}
+	else
+	{
+		getMovie(movie->genrePrev)->genreNext = movie->genreNext;
+	}
+
+	if (movie->genreNext == 0)
+	{
+		bucket->tail = getMovie(movie->genrePrev);
+	}
+	else
+	{
+		getMovie(movie->genreNext)->genrePrev = movie->genrePrev;
+	}
+
+	movie->genrePrev = 0;
+	movie->genreNext = 0;
+
+	if (--bucket->count == 0)
+	{
+		bucket->duration             = 0.0;
+		bucket->durationCompensation = 0.0;
+	}
+	else
+	{
+		addCompensated(&bucket->duration, &bucket->durationCompensation, -movie->duration);
+	}
+}
+
+/*
+// Adds a given Movie to the title and genre indexes of a given linked list of Movies.
+//
+// [in] list  - The linked list of Movies
+// [in] movie - The Movie to index
+//
+// Returns error status code.
+*/
+int indexMovie(MovieList* list, Movie* movie)
+{
+	int status = 0;
+
+	status = addToTitleIndex(&list->titleIndex, movie);
+
+	if (status == 0)
+	{
+		status = addToGenreIndex(list, movie);
+
+		if (status != 0)
+		{
+			removeFromTitleIndex(&list->titleIndex, movie);
+		}
+	}
+
+	if (status == 0 && list->searchIndex != NULL)
+	{
+		/*
+		// Losing track of a title only costs an early rebuild of the search index:
+		*/
+		if (noteSearchTitle(list->searchIndex, movie) != 0)
+		{
+			list->searchIndex->stale = true;
+		}
+	}
+
+	return status;
+}
+
+/*
+// Builds every index of a given linked list of Movies whose nodes were linked directly, which is
+// O(n) where appending them one at a time would not be. The title index doubles as the hash set
+// that finds duplicate titles: the first Movie with a title is kept and later ones are dropped
+// and reported, so every title can be found. Across library files loaded together the first file
+// listed wins.
+//
+// [in] list    - The linked list of Movies, linked through Movie::next only, with empty indexes
+// [in] reports - The ingest reports of the files the list was parsed from, by Movie::catalog
+//
+// Returns error status code.
+*/
+int indexMovieList(MovieList* list, IngestReport* reports)
+{
+	int    status                      = 0;
+	Movie* itr                         = NULL;
+	Movie* next                        = NULL;
+	Movie* previous                    = NULL;
+	int    catalog                     = 0;
+	int    positions[MAX_CATALOGS + 1] = {0};
+	int    cursors[MAX_CATALOGS + 1]   = {0};
+
+	status = reserveTitleIndex(&list->titleIndex, list->count);
+
+	for (itr = list->head; status == 0 && itr != NULL; itr = next, ++positions[catalog])
+	{
+		next    = getMovie(itr->next);
+		catalog = itr->catalog;
+
+		if (findInTitleIndex(&list->titleIndex, itr->title) == NULL)
+		{
+			status   = addToTitleIndex(&list->titleIndex, itr);
+			previous = itr;
+		}
+		else
+		{
+			if (previous == NULL)
+			{
+				list->head = next;
+			}
+			else
+			{
+				previous->next = itr->next;
+			}
+
+			list->tail = next == NULL ? previous : list->tail;
+			--list->count;
+			trackDuration(list, -itr->duration);
+
+			status = noteIngestIssue(&reports[catalog], DuplicateTitle, getIngestRecord(&reports[catalog], positions[catalog], &cursors[catalog]),
+			                         itr->title, itr->titleLength, false);
+			releaseMovie(getListPool(list), itr);
+		}
+	}
+
+	buildOrderIndex(list);
+
+	for (itr = list->head; status == 0 && itr != NULL; itr = getMovie(itr->next))
+	{
+		status = addToGenreIndex(list, itr);
+	}
+
+	return status;
+}
+
+/*
+// Returns the genre bucket of a given genre in a given linked list of Movies.
+//
+// [in] list    - The linked list of Movies
+// [in] genreId - The genre id
+//
+// Returns the bucket, or NULL if the list has no Movies of the genre.
+*/
+GenreBucket* getGenreBucket(MovieList* list, int genreId)
+{
+	GenreBucket* bucket = NULL;
+
+	if (genreId >= 0 && genreId < list->genreBucketCount && list->genreBuckets[genreId].count > 0)
+	{
+		bucket = &list->genreBuckets[genreId];
+	}
+
+	return bucket;
+}
+
+/*
+// Determines the count of Movies in a given linked list.
+//
+// [in] list - The linked list of Movies
+//
+// Returns the count of Movies.
+*/
+int getCount(MovieList* list)
+{
+	int count = 0;
+
+	if (list != NULL)
+	{
+		count = list->count;
+	}
+
+	return count;
+}
+
+/*
+// Appends a given Movie to the end of a given linked.
+//
+// [in] list     	- The linked list of Movies
+// [in] appendMovie - The Movie to append
+//
+// Returns error status code.
+*/
+int appendMovie(MovieList* list, Movie* appendMovie)
+{
+	int status = 0;
+
+	if (status == 0)
+	{
+		if (list == NULL || appendMovie == NULL)
+		{
+			status = EINVAL;
+		}
+	}
+
+	if (status == 0)
+	{
+		status = indexMovie(list, appendMovie);
+	}
+
+	if (status == 0)
+	{
+		if (list->tail == NULL)
+		{
+			list->head = appendMovie;
+		}
+		else
+		{
+			list->tail->next = getMovieId(appendMovie);
+		}
+
+		addToOrderIndex(list, appendMovie, list->count);
+		journalInsert(list->journal, appendMovie, list->count);
+
+		appendMovie->prev = getMovieId(list->tail);
+		appendMovie->next = 0;
+		list->tail        = appendMovie;
+		++list->count;
+		++list->revision;
+
+		trackDuration(list, appendMovie->duration);
+	}
+
+	return status;
+}
+
+/*
+// Inserts a given Movie into a given linked list at a given position (zero-based).
+//
+// [in] list     	- The linked list of Movies
+// [in] insertMovie - The Movie to insert
+// [in] position    - The position in the linked list at which to insert
+//
+// Returns error status code.
+*/
+int insertMovie(MovieList* list, Movie* insertMovie, int position)
+{
+	int    status = 0;
+	Movie* prev   = NULL;
+
+	if (status == 0)
+	{
+		if (list == NULL || insertMovie == NULL)
+		{
+			status = EINVAL;
+		}
+		else if (position < 0 || position > list->count)
+		{
+			status = ERANGE;
+		}
+	}
+
+	if (status == 0)
+	{
+		if (position == list->count)
+		{
+			status = appendMovie(list, insertMovie);
+		}
+		else
+		{
+			status = indexMovie(list, insertMovie);
+
+			if (status == 0)
+			{
+				prev = position == 0 ? NULL : getMovieAt(list, position - 1);
+
+				insertMovie->prev = getMovieId(prev);
+				insertMovie->next = prev == NULL ? getMovieId(list->head) : prev->next;
+				getMovie(insertMovie->next)->prev = getMovieId(insertMovie);
+
+				if (prev == NULL)
+				{
+					list->head = insertMovie;
+				}
+				else
+				{
+					prev->next = getMovieId(insertMovie);
+				}
+
+				addToOrderIndex(list, insertMovie, position);
+				journalInsert(list->journal, insertMovie, position);
+
+				++list->count;
+				++list->revision;
+
+				trackDuration(list, insertMovie->duration);
+			}
+		}
+	}
+
+	return status;
+}
+
+/*
+// Unlinks a given Movie from a given linked list of Movies and all of its indexes.
+//
+// [in] list    - The linked list of Movies, which must hold the Movie
+// [in] movie   - The Movie to unlink
+// [in] ordered - Whether to update the order index; if false the caller must rebuild it, see
+//                buildOrderIndex
+*/
+void unlinkMovie(MovieList* list, Movie* movie, bool ordered)
+{
+	if (movie->prev == 0)
+	{
+		list->head = getMovie(movie->next);
+	}
+	else
+	{
+		getMovie(movie->prev)->next = movie->next;
+	}
+
+	if (movie->next == 0)
+	{
+		list->tail = getMovie(movie->prev);
+	}
+	else
+	{
+		getMovie(movie->next)->prev = movie->prev;
+	}
+
+	if (ordered)
+	{
+		removeFromOrderIndex(list, movie);
+	}
+
+	journalChange(list->journal, 'R', movie);
+
+	movie->next = 0;
+	movie->prev = 0;
+	--list->count;
+	++list->revision;
+
+	if (list->count == 0)
+	{
+		list->duration             = 0.0;
+		list->durationCompensation = 0.0;
+	}
+	else
+	{
+		trackDuration(list, -movie->duration);
+	}
+
+	removeFromTitleIndex(&list->titleIndex, movie);
+	removeFromGenreIndex(list, movie);
+}
+
+/*
+// Removes a given Movie from a given linked list of Movies.
+//
+// [in] list	    - The linked list of Movies
+// [in] removeMovie - The Movie to remove
+//
+// Returns the removed Movie, or NULL on error.
+*/
+Movie* removeMovie(MovieList* list, Movie* removeMovie)
+{
+	int    status       = 0;
+	Movie* removedMovie = NULL;
+
+	if (status == 0)
+	{
+		if (list == NULL || list->head == NULL || getMoviePosition(list, removeMovie) < 0)
+		{
+			status       = EINVAL;
+			removedMovie = NULL;
+		}
+	}
+
+	if (status == 0)
+	{
+		removedMovie = removeMovie;
+
+		unlinkMovie(list, removedMovie, true);
+	}
+
+	return removedMovie;
+}
+
+/*
+// Removes a given Movie from a given linked list of Movies, and deletes it from memory.
+//
+// [in] list		- The linked list of Movies
+// [in] deleteMovie - The Movie to delete
+//
+// Returns 0 on success, -1 on failure.
+*/
+int deleteMovie(MovieList* list, Movie* deleteMovie)
+{
+	int status = 0;
+
+	if (status == 0)
+	{
+		if (list == NULL || list->head == NULL || deleteMovie == NULL)
+		{
+			status = -1;
+		}
+	}
+
+	if (status == 0)
+	{
+		if (removeMovie(list, deleteMovie) == NULL)
+		{
+			status = -1;
+		}
+		else
+		{
+			releaseMovie(getListPool(list), deleteMovie);
+		}
+	}
+
+	return status;
+}
+
+/*
+// Deletes from a given linked list one Movie for each Movie of another list with the same title,
+// in a single hash join against the list's title index. The remaining Movies keep their order.
+// When many Movies go, the order index is rebuilt once instead of updated per Movie.
+//
+// [in] list    - The linked list of Movies to delete from
+// [in] matches - The linked list of Movies whose titles to delete
+//
+// Returns the count of Movies deleted.
+*/
+int deleteMatchingMovies(MovieList* list, MovieList* matches)
+{
+	int    deleted = 0;
+	int    depth   = 0;
+	bool   rebuild = false;
+	Movie* itr     = NULL;
+	Movie* movie   = NULL;
+
+	if (list != NULL && matches != NULL)
+	{
+		for (depth = 1; (list->count >> depth) > 0; ++depth)
+		{
+		}
+
+		rebuild = (int64_t)matches->count * depth > list->count;
+
+		for (itr = matches->head; itr != NULL; itr = getMovie(itr->next))
+		{
+			movie = findInTitleIndex(&list->titleIndex, itr->title);
+
+			if (movie != NULL)
+			{
+				unlinkMovie(list, movie, !rebuild);
+				releaseMovie(getListPool(list), movie);
+				++deleted;
+			}
+		}
+
+		if (rebuild && deleted > 0)
+		{
+			buildOrderIndex(list);
+		}
+	}
+
+	return deleted;
+}
+
+/*
+// Deletes a given linked list of Movies from memory.
+//
+// [in] list - The linked list of Movies
+//
+// Returns 0 on success, -1 on failure.
+*/
+int deleteList(MovieList* list)
+{
+	int status = 0;
+	int order  = 0;
+
+	if (status == 0)
+	{
+		if (list == NULL || list->head == NULL)
+		{
+			status = -1;
+		}
+	}
+
+	if (status == 0)
+	{
+		/*
+		// The list is already linked through Movie::next, so it is handed back to the pool whole:
+		*/
+		releaseMovieChain(getListPool(list), list->head, list->tail, list->count);
+	}
+
+	if (list != NULL)
+	{
+		clearTitleIndex(&list->titleIndex);
+		clearMovieColumns(list);
+
+		for (order = 0; order < MOVIE_ORDER_COUNT; ++order)
+		{
+			clearSortedView(list, (MovieOrder)order);
+		}
+
+		free(list->genreBuckets);
+		list->genreBuckets     = NULL;
+		list->genreBucketCount = 0;
+		clearTitleSearchIndex(list->searchIndex);
+		list->searchIndex      = NULL;
+		closeJournal(list->journal);
+		list->journal          = NULL;
+		list->head                 = NULL;
+		list->tail                 = NULL;
+		list->orderRoot            = NULL;
+		list->count                = 0;
+		list->duration             = 0.0;
+		list->durationCompensation = 0.0;
+		++list->revision;
+	}
+
+	return status;
+}
+
+/*
+// Moves a given Movie from one linked list of Movies into another at a given position (zero-based).
+// The node itself is relinked, so nothing is allocated or copied, and the indexes of both lists are
+// updated in the same step.
+//
+// [in] source      - The linked list of Movies that holds the Movie
+// [in] destination - The linked list of Movies to move the Movie into
+// [in] movie       - The Movie to move
+// [in] position    - The position in the destination at which to insert
+//
+// Returns error status code. On error the Movie remains in (or is returned to the end of) the source.
+*/
+int transferMovie(MovieList* source, MovieList* destination, Movie* movie, int position)
+{
+	int status = 0;
+
+	if (status == 0)
+	{
+		if (source == NULL || destination == NULL || movie == NULL || source == destination)
+		{
+			status = EINVAL;
+		}
+		else if (position < 0 || position > destination->count)
+		{
+			status = ERANGE;
+		}
+	}
+
+	if (status == 0)
+	{
+		if (removeMovie(source, movie) == NULL)
+		{
+			status = EINVAL;
+		}
+	}
+
+	if (status == 0)
+	{
+		status = insertMovie(destination, movie, position);
+
+		if (status != 0)
+		{
+			appendMovie(source, movie);
+		}
+	}
+
+	return status;
+}
+
+/*
+// Moves given Movies from one linked list of Movies to the end of another, in the given order, as
+// one set operation: nothing is searched for, the destination's title index is grown once, and
+// when enough Movies leave the source its order index is rebuilt once instead of updated for each
+// one, see deleteMatchingMovies.
+//
+// [in] source      - The linked list of Movies that holds the Movies
+// [in] destination - The linked list of Movies to append them to
+// [in] movies      - The Movies to move, each in the source once
+// [in] count       - The count of Movies
+//
+// Returns error status code, EINVAL if a Movie is not in the source. On error the Movies not yet
+// moved remain in the source, one that failed to append at its end.
+*/
+int transferMovies(MovieList* source, MovieList* destination, Movie** movies, int count)
+{
+	int  status  = 0;
+	int  depth   = 0;
+	bool rebuild = false;
+	int  i       = 0;
+
+	if (source == NULL || destination == NULL || source == destination || count < 0)
+	{
+		status = EINVAL;
+	}
+
+	if (status == 0 && count > 0)
+	{
+		for (depth = 1; (source->count >> depth) > 0; ++depth)
+		{
+		}
+
+		rebuild = (int64_t)count * depth > source->count;
+
+		/*
+		// Growing up front only saves rehashing; each append still grows the table itself if this
+		// fails:
+		*/
+		reserveTitleIndex(&destination->titleIndex, count);
+
+		for (i = 0; status == 0 && i < count; ++i)
+		{
+			/*
+			// The title index, unlike the order index, stays current while Movies leave, so it
+			// catches a Movie that is not in the source or was listed twice:
+			*/
+			if (findInTitleIndex(&source->titleIndex, movies[i]->title) != movies[i])
+			{
+				status = EINVAL;
+				break;
+			}
+
+			unlinkMovie(source, movies[i], !rebuild);
+
+			status = appendMovie(destination, movies[i]);
+
+			if (status != 0)
+			{
+				if (rebuild)
+				{
+					buildOrderIndex(source);
+					rebuild = false;
+				}
+
+				appendMovie(source, movies[i]);
+			}
+		}
+
+		if (rebuild)
+		{
+			buildOrderIndex(source);
+		}
+	}
+
+	return status;
+}
+
+/*
+// Finds the Movie preceding a given Movie in a given linked list of Movies.
+//
+// [in] list  - The linked list of Movies
+// [in] movie - The Movie whose predecessor to find
+//
+// Returns the preceding Movie, or NULL if the given Movie is the head or not in the list.
+*/
+Movie* getPreviousMovie(MovieList* list, Movie* movie)
+{
+	Movie* prev = NULL;
+
+	if (getMoviePosition(list, movie) >= 0)
+	{
+		prev = getMovie(movie->prev);
+	}
+
+	return prev;
+}
+
+/*
+// Swaps a given Movie with the Movie following it in a given linked list of Movies.
+//
+// [in] list  - The linked list of Movies
+// [in] movie - The Movie to swap with its successor
+//
+// Returns error status code.
+*/
+int swapWithNextMovie(MovieList* list, Movie* movie)
+{
+	int    status   = 0;
+	int    position = getMoviePosition(list, movie);
+	Movie* prev     = NULL;
+	Movie* next     = NULL;
+
+	if (status == 0)
+	{
+		if (position < 0 || movie->next == 0)
+		{
+			status = EINVAL;
+		}
+	}
+
+	if (status == 0)
+	{
+		prev = getMovie(movie->prev);
+		next = getMovie(movie->next);
+
+		if (prev == NULL)
+		{
+			list->head = next;
+		}
+		else
+		{
+			prev->next = getMovieId(next);
+		}
+
+		if (next->next == 0)
+		{
+			list->tail = movie;
+		}
+		else
+		{
+			getMovie(next->next)->prev = getMovieId(movie);
+		}
+
+		movie->next = next->next;
+		movie->prev = getMovieId(next);
+		next->next  = getMovieId(movie);
+		next->prev  = getMovieId(prev);
+
+		removeFromOrderIndex(list, next);
+		addToOrderIndex(list, next, position);
+		journalChange(list->journal, 'S', movie);
+
+		++list->revision;
+	}
+
+	return status;
+}
+
+/*
+// Prints a given Movie.
+//
+// [in] movie - The Movie to print
+*/
+void printMovie(Movie* movie)
+{
+	int         status  = 0;
+	const char* catalog = NULL;
+
+	if (status == 0)
+	{
+		if (movie == NULL)
+		{
+			status = EINVAL;
+		}
+	}
+
+	if (status == 0)
+	{
+		catalog = getCatalogName(movie->catalog);
+
+		printf("%s (%s, %.2f hours)", movie->title, getGenreName(movie->genreId), movie->duration);
+
+		if (catalog != NULL)
+		{
+			printf(" [%s]", catalog);
+		}
+
+		printf("\n");
+	}
+
+	if (status != 0)
+	{
+		errno = status;
+	}
+}
+
+#define PRINT_BUFFER_SIZE   (64 * 1024)
+#define LIST_PAGE_SIZE      25
+#define MOVIE_TEXT_CAPACITY (MAX_TITLE_LENGTH + MAX_GENRE_LENGTH + MAX_CATALOG_NAME_LENGTH + 340)
+
+static char printBuffer[PRINT_BUFFER_SIZE];
+
+/*
+// Formats a given Movie the way printMovie prints it, without going through printf for the common
+// case of a finite duration.
+//
+// [out] buffer - The buffer, with room for at least MOVIE_TEXT_CAPACITY characters (any double fits
+//                in 320)
+// [in]  movie  - The Movie to format
+//
+// Returns the count of characters written.
+*/
+size_t formatMovie(char* buffer, const Movie* movie)
+{
+	const char* genre      = getGenreName(movie->genreId);
+	const char* catalog    = getCatalogName(movie->catalog);
+	size_t      length     = 0;
+	size_t      part       = 0;
+	int         written    = 0;
+	double      scaled     = movie->duration * 100.0;
+	long long   hundredths = 0;
+	char        digits[24];
+	int         digitCount = 0;
+
+	part = strlen(movie->title);
+	memcpy(buffer, movie->title, part);
+	length += part;
+
+	buffer[length++] = ' ';
+	buffer[length++] = '(';
+
+	part = strlen(genre);
+	memcpy(buffer + length, genre, part);
+	length += part;
+
+	buffer[length++] = ',';
+	buffer[length++] = ' ';
+
+	/*
+	// Durations close to a rounding tie go through snprintf so the output always matches "%.2f":
+	*/
+	if (!signbit(movie->duration) && scaled < 1e15 && fabs(scaled - floor(scaled) - 0.5) > 1e-6)
+	{
+		hundredths = (long long)(scaled + 0.5);
+
+		do
+		{
+			digits[digitCount++] = (char)('0' + hundredths % 10);
+			hundredths          /= 10;
+		}
+		while (hundredths > 0 || digitCount < 3);
+
+		while (digitCount > 2)
+		{
+			buffer[length++] = digits[--digitCount];
+		}
+
+		buffer[length++] = '.';
+		buffer[length++] = digits[1];
+		buffer[length++] = digits[0];
+	}
+	else
+	{
+		written = snprintf(buffer + length, 320, "%.2f", movie->duration);
+		length += written < 320 ? (size_t)written : 319;
+	}
+
+	memcpy(buffer + length, " hours)", 7);
+	length += 7;
+
+	/*
+	// Movies loaded from several library files say which one they came from:
+	*/
+	if (catalog != NULL)
+	{
+		buffer[length++] = ' ';
+		buffer[length++] = '[';
+
+		part = strlen(catalog);
+		memcpy(buffer + length, catalog, part);
+		length += part;
+
+		buffer[length++] = ']';
+	}
+
+	buffer[length++] = '\n';
+
+	return length;
+}
+
+/*
+// Prints a given count of Movies starting at a given Movie, formatting them into a shared buffer
+// that is written out a block at a time.
+//
+// [in] movie - The first Movie to print
+// [in] count - The maximum count of Movies to print
+*/
+void printMovieRun(Movie* movie, int count)
+{
+	size_t length = 0;
+
+	for (; movie != NULL && count > 0; movie = getMovie(movie->next), --count)
+	{
+		if (length > PRINT_BUFFER_SIZE - MOVIE_TEXT_CAPACITY)
+		{
+			fwrite(printBuffer, 1, length, stdout);
+			length = 0;
+		}
+
+		length += formatMovie(printBuffer + length, movie);
+	}
+
+	fwrite(printBuffer, 1, length, stdout);
+}
+
+/*
+// Prints the Movies in a given linked list of Movies.
+//
+// [in] list - The linked list of Movies to print
+*/
+void printMovieList(MovieList* list)
+{
+	int status = 0;
+
+	if (status == 0)
+	{
+		if (list == NULL || list->head == NULL)
+		{
+			status = EINVAL;
+		}
+	}
+
+	if (status == 0)
+	{
+		printMovieRun(list->head, list->count);
+	}
+	printf("\n");
+}
+
+/*
+// Prints the Movies in a given linked list of Movies a page at a time, prompting for the page to
+// show next. Each page is located through the order index, so only the pages viewed are rendered.
+//
+// [in] list - The linked list of Movies to print
+*/
+void printMoviePages(MovieList* list)
+{
+	int pageCount = 0;
+	int page      = 1;
+
+	if (list == NULL || list->count <= LIST_PAGE_SIZE)
+	{
+		printMovieList(list);
+		page = 0;
+	}
+	else
+	{
+		pageCount = (list->count + LIST_PAGE_SIZE - 1) / LIST_PAGE_SIZE;
+	}
+
+	while (page > 0)
+	{
+		printf("%d movies, page %d of %d:\n", list->count, page, pageCount);
+
+		printMovieRun(getMovieAt(list, (page - 1) * LIST_PAGE_SIZE), LIST_PAGE_SIZE);
+		printf("\n");
+
+		page = promptForInt(0, pageCount, "Enter a page to show, or 0 to stop: ");
+
+		if (page > 0)
+		{
+			printf("\n");
+		}
+	}
+}
+
+/*
+// Computes the total duration in hours of a given linked list of movies. The total is maintained
+// incrementally by the list mutators, so this is constant-time.
+//
+// [in] list - The linked list of Movies
+//
+// Returns the computed duration.
+*/
+double computeDuration(MovieList* list)
+{
+	double duration = 0.0;
+
+	if (list == NULL)
+	{
+		errno = EINVAL;
+	}
+	else
+	{
+		duration = list->duration + list->durationCompensation;
+	}
+
+	return duration;
+}
+
+/*
+// Searches for a Movie by its given title in a given linked list of Movies.
+//
+// [in] list  - The linked list of Movies
+// [in] title - The title of the Movie to search for
+//
+// Returns the Movie with the given title, or NULL if not found.
+*/
+Movie* searchByTitle(MovieList* list, const char* title)
+{
+	Movie* movie = NULL;
+
+	if (list != NULL && title != NULL)
+	{
+		movie = findInTitleIndex(&list->titleIndex, title);
+	}
+
+	return movie;
+}
+
+/*
+// Determines the position (zero-based) of a Movie by its given title in a given linked list of Movies.
+//
+// [in] list  - The linked list of Movies
+// [in] title - The title of the Movie to find position
+//
+// Returns the position of the Movie, or -1 if not found.
+*/
+int getNodePosition(MovieList* list, char* title)
+{
+	return getMoviePosition(list, searchByTitle(list, title));
+}
+
+/*=========================================================================================================
+// File Mapping
+//=======================================================================================================*/
+
+/*
+// Encapsulates a read-only memory mapping of an entire file.
+*/
+typedef struct FileMapping
+{
+	const char* data;
+	size_t      size;
+#ifdef _WIN32
+	HANDLE      file;
+	HANDLE      mapping;
+#endif
+} FileMapping;
+
+/*
+// Maps a given file read-only into memory. An empty file maps to a NULL view of size zero.
+//
+// [in]  fileName - The name of the file
+// [out] mapping  - The file mapping
+//
+// Returns error status code.
+*/
+int mapFile(const char* fileName, FileMapping* mapping)
+{
+	int status = 0;
+
+	memset(mapping, 0, sizeof(FileMapping));
+
+#ifdef _WIN32
+	{
+		LARGE_INTEGER size = {0};
+
+		mapping->file = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+		if (mapping->file == INVALID_HANDLE_VALUE)
+		{
+			status = GetLastError() == ERROR_FILE_NOT_FOUND ? ENOENT : EIO;
+		}
+		else if (!GetFileSizeEx(mapping->file, &size) || (unsigned long long)size.QuadPart > (size_t)-1)
+		{
+			status = EFBIG;
+		}
+		else if (size.QuadPart > 0)
+		{
+			mapping->size    = (size_t)size.QuadPart;
+			mapping->mapping = CreateFileMappingA(mapping->file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+			if (mapping->mapping == NULL || (mapping->data = MapViewOfFile(mapping->mapping, FILE_MAP_READ, 0, 0, 0)) == NULL)
+			{
+				status = ENOMEM;
+			}
+		}
+
+		if (status != 0)
+		{
+			if (mapping->mapping != NULL)
+			{
+				CloseHandle(mapping->mapping);
+			}
+
+			if (mapping->file != INVALID_HANDLE_VALUE)
+			{
+				CloseHandle(mapping->file);
+			}
+
+			memset(mapping, 0, sizeof(FileMapping));
+		}
+	}
+#else
+	{
+		int         descriptor = -1;
+		struct stat info;
+		void*       data       = NULL;
+
+		descriptor = open(fileName, O_RDONLY);
+
+		if (descriptor < 0)
+		{
+			status = errno;
+		}
+		else if (fstat(descriptor, &info) != 0)
+		{
+			status = errno;
+		}
+		else if (!S_ISREG(info.st_mode))
+		{
+			status = ENODEV;
+		}
+		else if (info.st_size > 0)
+		{
+			data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+
+			if (data == MAP_FAILED)
+			{
+				status = errno;
+			}
+			else
+			{
+				mapping->data = data;
+				mapping->size = (size_t)info.st_size;
+			}
+		}
+
+		if (descriptor >= 0)
+		{
+			close(descriptor);
+		}
+	}
+#endif
+
+	if (status == 0)
+	{
+		STATS_ADD(bytesRead, mapping->size);
+	}
+
+	return status;
+}
+
+/*
+// Releases a given file mapping.
+//
+// [in] mapping - The file mapping
+*/
+void unmapFile(FileMapping* mapping)
+{
+#ifdef _WIN32
+	if (mapping->data != NULL)
+	{
+		UnmapViewOfFile(mapping->data);
+		CloseHandle(mapping->mapping);
+	}
+
+	if (mapping->file != NULL && mapping->file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(mapping->file);
+	}
+#else
+	if (mapping->data != NULL)
+	{
+		munmap((void*)mapping->data, mapping->size);
+	}
+#endif
+
+	memset(mapping, 0, sizeof(FileMapping));
+}
+
+/*
+// Finds the end of the line starting at a given position, excluding any trailing carriage return.
+//
+// [in]  begin - The start of the line
+// [in]  end   - The end of the buffer
+// [out] next  - The start of the following line
+//
+// Returns the end of the line's content.
+*/
+const char* scanLine(const char* begin, const char* end, const char** next)
+{
+	const char* newline = memchr(begin, '\n', end - begin);
+	const char* last    = newline != NULL ? newline : end;
+
+	*next = newline != NULL ? newline + 1 : end;
+
+	if (last > begin && last[-1] == '\r')
+	{
+		--last;
+	}
+
+	return last;
+}
+
+/*
+// Parses a duration in hours from a line of bytes that need not be null-terminated.
+//
+// [in]  begin - The start of the line
+// [in]  end   - The end of the line's content
+// [out] valid - Whether the whole line is a number, or NULL
+//
+// Returns the parsed duration, or 0.0 if the line is not a number.
+*/
+double parseDuration(const char* begin, const char* end, bool* valid)
+{
+	char   buffer[64] = {0};
+	int    length     = (int)(end - begin);
+	char*  rest       = NULL;
+	double duration   = 0.0;
+
+	if (length > (int)_countof(buffer) - 1)
+	{
+		length = _countof(buffer) - 1;
+	}
+
+	memcpy(buffer, begin, length);
+
+	duration = strtod(buffer, &rest);
+
+	if (valid != NULL)
+	{
+		*valid = rest != buffer && rest[strspn(rest, " \t\r")] == '\0' && length == (int)(end - begin);
+	}
+
+	return duration;
+}
+
+/*
+// Checks the fields of one library record, in either format, see IngestIssue.
+//
+// [in] titleLength - The byte length of the title
+// [in] genreLength - The byte length of the genre
+// [in] duration    - The duration in hours
+//
+// Returns the issue of the record, or -1 if it is valid.
+*/
+int checkMovieFields(size_t titleLength, size_t genreLength, double duration)
+{
+	int issue = -1;
+
+	if (titleLength == 0 || titleLength > MAX_TITLE_LENGTH || genreLength == 0 || genreLength > MAX_GENRE_LENGTH)
+	{
+		issue = MalformedRecord;
+	}
+	else if (!(duration > 0.0 && duration <= MAX_DURATION_HOURS))
+	{
+		issue = DurationOutOfRange;
+	}
+
+	return issue;
+}
+
+/*
+// Checks one title/genre/duration record of a library file, see IngestIssue.
+//
+// [in]  title    - The start of the title line
+// [in]  titleEnd - The end of the title
+// [in]  genre    - The start of the genre line
+// [in]  genreEnd - The end of the genre
+// [in]  line     - The start of the duration line
+// [in]  lineEnd  - The end of the duration
+// [out] duration - The parsed duration
+//
+// Returns the issue of the record, or -1 if it is valid.
+*/
+int validateMovieRecord(const char* title, const char* titleEnd, const char* genre, const char* genreEnd, const char* line,
+                        const char* lineEnd, double* duration)
+{
+	int  issue = -1;
+	bool valid = false;
+
+	*duration = parseDuration(line, lineEnd, &valid);
+	issue     = valid ? checkMovieFields(titleEnd - title, genreEnd - genre, *duration) : MalformedRecord;
+
+	return issue;
+}
+
+/*
+// Appends a given Movie to a given list maintaining only the next links, tail and count, for lists
+// indexed as a whole afterwards, see indexMovieList.
+//
+// [in] list  - The linked list of Movies
+// [in] movie - The Movie to append
+*/
+void linkMovie(MovieList* list, Movie* movie)
+{
+	if (list->tail == NULL)
+	{
+		list->head = movie;
+	}
+	else
+	{
+		list->tail->next = getMovieId(movie);
+	}
+
+	list->tail = movie;
+	++list->count;
+	++list->revision;
+
+	trackDuration(list, movie->duration);
+}
+
+/*
+// Parses newline-delimited title/genre/duration records from a given buffer in a single pass,
+// creating each Movie directly from the buffered bytes and appending it to a given list. Invalid
+// records are dropped and reported, see validateMovieRecord; a line too long for a record still
+// counts as one line, so the records after it stay aligned.
+//
+// [in]     begin   - The start of the buffer
+// [in]     end     - The end of the buffer
+// [in]     pool    - The Movie pool to allocate from
+// [in]     list    - The linked list of Movies to append to
+// [in]     indexed - Whether to index the Movies as they are appended; if false only the next links,
+//                    tail and count are maintained and the caller must call indexMovieList
+// [in,out] report  - The ingest report, with firstRecord set to the number of the first record
+//
+// Returns error status code.
+*/
+int parseMovieRecords(const char* begin, const char* end, MoviePool* pool, MovieList* list, bool indexed, IngestReport* report)
+{
+	int         status     = 0;
+	const char* itr        = begin;
+	const char* title      = NULL;
+	const char* titleEnd   = NULL;
+	const char* genre      = NULL;
+	const char* genreEnd   = NULL;
+	const char* line       = NULL;
+	const char* lineEnd    = NULL;
+	const char* blank      = NULL;
+	const char* lastGenre  = NULL;
+	int         lastLength = -1;
+	int         genreId    = -1;
+	int         issue      = -1;
+	double      duration   = 0.0;
+	Movie*      movie      = NULL;
+
+	while (status == 0 && itr < end)
+	{
+		/*
+		// Stop at trailing blank lines rather than reading an empty record:
+		*/
+		for (blank = itr; blank < end && (*blank == '\n' || *blank == '\r'); ++blank)
+		{
+		}
+
+		if (blank == end)
+		{
+			break;
+		}
+
+		title    = itr;
+		titleEnd = scanLine(title, end, &genre);
+		genreEnd = scanLine(genre, end, &line);
+		lineEnd  = scanLine(line, end, &itr);
+		issue    = validateMovieRecord(title, titleEnd, genre, genreEnd, line, lineEnd, &duration);
+
+		if (issue >= 0)
+		{
+			status = noteIngestIssue(report, (IngestIssue)issue, report->firstRecord + report->records++, title, titleEnd - title, true);
+			continue;
+		}
+
+		++report->records;
+
+		/*
+		// Runs of one genre are common, so only intern when the genre changes:
+		*/
+		if (lastLength != (int)(genreEnd - genre) || memcmp(lastGenre, genre, lastLength) != 0)
+		{
+			lastGenre  = genre;
+			lastLength = (int)(genreEnd - genre);
+			genreId    = internGenre(genre, lastLength);
+		}
+
+		movie = genreId < 0 ? NULL : createMovieNodeWithGenre(pool, title, (int)(titleEnd - title), genreId, duration);
+
+		if (movie == NULL)
+		{
+			status = errno;
+		}
+		else if (indexed)
+		{
+			status = appendMovie(list, movie);
+		}
+		else
+		{
+			linkMovie(list, movie);
+		}
+	}
+
+	return status;
+}
+
+/*=========================================================================================================
+// Parallel Parsing
+//=======================================================================================================*/
+
+#ifndef PARALLEL_LOAD_MIN_BYTES
+#define PARALLEL_LOAD_MIN_BYTES (4 * 1024 * 1024)  /* below this a single thread is faster */
+#endif
+
+#define PARALLEL_LOAD_MAX_WORKERS 64
+
+/*
+// State for one worker of a parallel parse.
+*/
+typedef struct ParseWorker
+{
+	Thread      thread;
+	const char* begin;
+	const char* end;
+	size_t      lineCount;
+	MoviePool    pool;
+	MovieList    list;
+	IngestReport report;
+	int          status;
+} ParseWorker;
+
+/*
+// Counts the newlines in a worker's chunk.
+//
+// [in] worker - The ParseWorker
+*/
+void countLinesWorker(void* worker)
+{
+	ParseWorker* self = worker;
+	const char*  itr  = self->begin;
+
+	self->lineCount = 0;
+
+	while (itr < self->end && (itr = memchr(itr, '\n', self->end - itr)) != NULL)
+	{
+		++self->lineCount;
+		++itr;
+	}
+}
+
+/*
+// Parses the records of a worker's chunk into its own list and pool.
+//
+// [in] worker - The ParseWorker
+*/
+void parseRecordsWorker(void* worker)
+{
+	ParseWorker* self = worker;
+
+	self->status = parseMovieRecords(self->begin, self->end, &self->pool, &self->list, false, &self->report);
+}
+
+/*
+// Appends the Movies of one list that is linked through Movie::next only to another such list,
+// leaving the first list empty.
+//
+// [in] list  - The linked list of Movies to append to
+// [in] other - The linked list of Movies to append
+*/
+void linkMovieChain(MovieList* list, MovieList* other)
+{
+	if (other->head != NULL)
+	{
+		if (list->tail == NULL)
+		{
+			list->head = other->head;
+		}
+		else
+		{
+			list->tail->next = getMovieId(other->head);
+		}
+
+		list->tail   = other->tail;
+		list->count += other->count;
+		++list->revision;
+
+		trackDuration(list, other->duration);
+		trackDuration(list, other->durationCompensation);
+
+		other->head                 = NULL;
+		other->tail                 = NULL;
+		other->count                = 0;
+		other->duration             = 0.0;
+		other->durationCompensation = 0.0;
+	}
+}
+
+/*
+// Runs a given function over every worker, on threads where possible.
+//
+// [in] workers     - The ParseWorkers
+// [in] workerCount - The count of ParseWorkers
+// [in] function    - The function to run for each worker
+*/
+void runParseWorkers(ParseWorker* workers, int workerCount, ThreadFunction function)
+{
+	int  i                                   = 0;
+	bool started[PARALLEL_LOAD_MAX_WORKERS] = {0};
+
+	/*
+	// The calling thread takes the first chunk itself:
+	*/
+	for (i = 1; i < workerCount; ++i)
+	{
+		started[i] = startThread(&workers[i].thread, function, &workers[i]) == 0;
+
+		if (!started[i])
+		{
+			function(&workers[i]);
+		}
+	}
+
+	function(&workers[0]);
+
+	for (i = 1; i < workerCount; ++i)
+	{
+		if (started[i])
+		{
+			joinThread(&workers[i].thread);
+		}
+	}
+}
+
+/*
+// Parses newline-delimited title/genre/duration records from a given buffer on several threads.
+// The buffer is split into line-aligned chunks whose newlines are counted in parallel, after which
+// each chunk start is advanced to the next 3-line record boundary. The chunks are then parsed in
+// parallel, validating their records as they go, and their lists and reports concatenated in file
+// order. The caller then indexes the list, which drops duplicate titles, see indexMovieList.
+//
+// [in]  begin       - The start of the buffer
+// [in]  end         - The end of the buffer
+// [in]  workerCount - The count of threads to use
+// [in]  pool        - The Movie pool to adopt the parsed Movies
+// [in]  list        - The empty linked list of Movies to fill
+// [out] report      - The empty ingest report to fill
+//
+// Returns error status code.
+*/
+int parseMovieRecordsParallel(const char* begin, const char* end, int workerCount, MoviePool* pool, MovieList* list, IngestReport* report)
+{
+	int          status     = 0;
+	ParseWorker* workers    = NULL;
+	const char*  split      = NULL;
+	const char*  newline    = NULL;
+	size_t       lineNumber = 0;
+	int          skip       = 0;
+	int          i          = 0;
+
+	if (workerCount > PARALLEL_LOAD_MAX_WORKERS)
+	{
+		workerCount = PARALLEL_LOAD_MAX_WORKERS;
+	}
+
+	if (status == 0)
+	{
+		workers = calloc(workerCount, sizeof(ParseWorker));
+
+		if (workers == NULL)
+		{
+			status = ENOMEM;
+		}
+	}
+
+	if (status == 0)
+	{
+		/*
+		// Split into roughly equal chunks, each starting at the beginning of a line:
+		*/
+		workers[0].begin = begin;
+
+		for (i = 1; i < workerCount; ++i)
+		{
+			split   = begin + (end - begin) / workerCount * i;
+			split   = split < workers[i - 1].begin ? workers[i - 1].begin : split;
+			newline = memchr(split, '\n', end - split);
+
+			workers[i].begin   = newline != NULL ? newline + 1 : end;
+			workers[i - 1].end = workers[i].begin;
+		}
+
+		workers[workerCount - 1].end = end;
+
+		runParseWorkers(workers, workerCount, countLinesWorker);
+
+		/*
+		// Advance each chunk start to the next line whose number is a multiple of 3:
+		*/
+		for (i = 1; i < workerCount; ++i)
+		{
+			lineNumber += workers[i - 1].lineCount;
+
+			skip = (int)((3 - lineNumber % 3) % 3);
+
+			workers[i].report.firstRecord = (int)((lineNumber + skip) / 3);
+
+			for (; skip > 0 && workers[i].begin < end; --skip)
+			{
+				scanLine(workers[i].begin, end, &workers[i].begin);
+			}
+
+			workers[i - 1].end = workers[i].begin;
+		}
+
+		runParseWorkers(workers, workerCount, parseRecordsWorker);
+
+		/*
+		// Adopt the workers' nodes and concatenate their lists in file order:
+		*/
+		for (i = 0; i < workerCount; ++i)
+		{
+			if (pool == &moviePool)
+			{
+				STATS_ADD(nodesCreated, workers[i].pool.liveCount);
+			}
+
+			mergeMoviePool(pool, &workers[i].pool);
+
+			if (workers[i].status != 0 && status == 0)
+			{
+				status = workers[i].status;
+			}
+
+			if (mergeIngestReport(report, &workers[i].report) != 0 && status == 0)
+			{
+				status = ENOMEM;
+			}
+
+			linkMovieChain(list, &workers[i].list);
+		}
+	}
+
+	free(workers);
+
+	return status;
+}
+
+/*=========================================================================================================
+// Stream Reading
+//=======================================================================================================*/
+
+#ifndef STREAM_CHUNK_SIZE
+#define STREAM_CHUNK_SIZE (1 << 20)  /* bytes read ahead while the previous ones are parsed */
+#endif
+
+/*
+// One chunk of a file read on a background thread, see readStreamChunk.
+*/
+typedef struct StreamChunk
+{
+	FILE*  input;
+	char*  data;    /* STREAM_CHUNK_SIZE bytes */
+	size_t size;    /* read; short only at the end of the file */
+	int    status;
+} StreamChunk;
+
+/*
+// Thread function reading the next chunk of a file.
+//
+// [in] chunk - The StreamChunk
+*/
+void readStreamChunk(void* chunk)
+{
+	StreamChunk* stream = chunk;
+
+	stream->size   = fread(stream->data, 1, STREAM_CHUNK_SIZE, stream->input);
+	stream->status = ferror(stream->input) ? EIO : 0;
+}
+
+/*
+// Returns the end of the last complete three-line record of a given buffer that starts a record.
+//
+// [in] begin - The start of the buffer
+// [in] end   - The end of the buffer
+*/
+const char* findRecordsEnd(const char* begin, const char* end)
+{
+	const char* recordsEnd = begin;
+	const char* newline    = NULL;
+	int         lines      = 0;
+
+	for (newline = memchr(begin, '\n', end - begin); newline != NULL; newline = memchr(newline + 1, '\n', end - newline - 1))
+	{
+		if (++lines % 3 == 0)
+		{
+			recordsEnd = newline + 1;
+		}
+	}
+
+	return recordsEnd;
+}
+
+/*
+// Reads title/genre/duration records from a given file that cannot be memory-mapped (e.g. a pipe),
+// appending them to a given list as parseMovieRecords does. A background thread reads each chunk
+// of the file while the records of the one before are parsed, so reading and parsing overlap.
+//
+// [in]     input  - The file
+// [in]     pool   - The Movie pool to allocate from
+// [in]     list   - The linked list of Movies to append to; the caller must call indexMovieList
+// [in,out] report - The ingest report
+//
+// Returns error status code.
+*/
+int readMovieRecords(FILE* input, MoviePool* pool, MovieList* list, IngestReport* report)
+{
+	int         status       = 0;
+	StreamChunk chunks[2]    = {{0}};
+	Thread      reader       = {0};
+	bool        reading      = false;
+	bool        done         = false;
+	int         current      = 0;
+	char*       pending      = NULL;
+	char*       grown        = NULL;
+	size_t      pendingSize  = 0;
+	size_t      pendingSpace = 0;
+	const char* recordsEnd   = NULL;
+
+	chunks[0].input = input;
+	chunks[0].data  = malloc(STREAM_CHUNK_SIZE);
+	chunks[1].input = input;
+	chunks[1].data  = malloc(STREAM_CHUNK_SIZE);
+
+	if (chunks[0].data == NULL || chunks[1].data == NULL)
+	{
+		status = ENOMEM;
+	}
+
+	if (status == 0)
+	{
+		readStreamChunk(&chunks[0]);
+		status = chunks[0].status;
+	}
+
+	while (status == 0 && !done)
+	{
+		done = chunks[current].size < STREAM_CHUNK_SIZE;
+
+		if (!done)
+		{
+			status  = startThread(&reader, readStreamChunk, &chunks[1 - current]);
+			reading = status == 0;
+		}
+
+		/*
+		// Records can span chunks, so the bytes after the last complete record are carried over:
+		*/
+		if (status == 0 && pendingSize + chunks[current].size > pendingSpace)
+		{
+			pendingSpace = pendingSize + chunks[current].size;
+			grown        = realloc(pending, pendingSpace);
+
+			if (grown == NULL)
+			{
+				status = ENOMEM;
+			}
+			else
+			{
+				pending = grown;
+			}
+		}
+
+		if (status == 0 && chunks[current].size > 0)
+		{
+			memcpy(pending + pendingSize, chunks[current].data, chunks[current].size);
+			pendingSize += chunks[current].size;
+		}
+
+		if (status == 0 && pendingSize > 0)
+		{
+			recordsEnd = done ? pending + pendingSize : findRecordsEnd(pending, pending + pendingSize);
+			status     = parseMovieRecords(pending, recordsEnd, pool, list, false, report);
+
+			pendingSize -= recordsEnd - pending;
+			memmove(pending, recordsEnd, pendingSize);
+		}
+
+		if (reading)
+		{
+			joinThread(&reader);
+
+			reading = false;
+			current = 1 - current;
+			status  = status == 0 ? chunks[current].status : status;
+		}
+	}
+
+	free(chunks[0].data);
+	free(chunks[1].data);
+	free(pending);
+
+	return status;
+}
+
+/*=========================================================================================================
+// Binary Format
+//=======================================================================================================*/
+
+#define BINARY_FILE_EXTENSION ".mwl"
+#define BINARY_FILE_MAGIC     "MWLB"
+#define BINARY_FILE_VERSION   1
+#define BINARY_BYTE_ORDER     0x01020304u
+
+/*
+// Header of a binary library or watchlist file. It is followed by `count` BinaryRecords and then
+// a string table of `stringTableSize` bytes holding the (unterminated) titles and genres.
+*/
+typedef struct BinaryHeader
+{
+	char     magic[4];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint32_t count;
+	uint64_t stringTableSize;
+	uint64_t reserved;
+} BinaryHeader;
+
+/*
+// A fixed-size Movie record of a binary file. Offsets are relative to the string table.
+*/
+typedef struct BinaryRecord
+{
+	uint32_t titleOffset;
+	uint32_t titleLength;
+	uint32_t genreOffset;
+	uint32_t genreLength;
+	double   duration;  /* hours, stored exactly */
+} BinaryRecord;
+
+/*
+// Determines whether a given file name selects the binary format by its extension.
+//
+// [in] fileName - The file name
+//
+// Returns true if the file is binary.
+*/
+bool isBinaryFileName(const char* fileName)
+{
+	size_t length          = strlen(fileName);
+	size_t extensionLength = strlen(BINARY_FILE_EXTENSION);
+
+	return length >= extensionLength && strcmp(fileName + length - extensionLength, BINARY_FILE_EXTENSION) == 0;
+}
+
+/*
+// Reads a given binary file with a single mapping and stores the contents as a linked list of Movies.
+//
+// [in]  fileName - The name of the binary file
+// [in]  pool     - The Movie pool to allocate from
+// [out] list     - The empty linked list of Movies to fill
+// [in]  indexed  - Whether to index the Movies as they are appended; if false the caller must call
+//                  indexMovieList
+// [out] report   - The empty ingest report to fill; records are checked as text records are, see
+//                  checkMovieFields, and numbered by their index in the file
+//
+// Returns error status code.
+*/
+int loadMovieListBinary(const char* fileName, MoviePool* pool, MovieList* list, bool indexed, IngestReport* report)
+{
+	int                 status  = 0;
+	FileMapping         mapping = {0};
+	const BinaryHeader* header  = NULL;
+	const BinaryRecord* records = NULL;
+	const char*         strings = NULL;
+	Movie*              movie   = NULL;
+	uint32_t            i       = 0;
+	int                 issue   = -1;
+
+	if (status == 0)
+	{
+		status = mapFile(fileName, &mapping);
+	}
+
+	if (status == 0)
+	{
+		header = (const BinaryHeader*)mapping.data;
+
+		if (mapping.size < sizeof(BinaryHeader) || memcmp(header->magic, BINARY_FILE_MAGIC, sizeof(header->magic)) != 0)
+		{
+			status = EILSEQ;
+		}
+		else if (header->version != BINARY_FILE_VERSION || header->byteOrder != BINARY_BYTE_ORDER)
+		{
+			status = ENOTSUP;
+		}
+		else if ((mapping.size - sizeof(BinaryHeader)) / sizeof(BinaryRecord) < header->count ||
+		         mapping.size - sizeof(BinaryHeader) - header->count * sizeof(BinaryRecord) < header->stringTableSize)
+		{
+			status = EILSEQ;
+		}
+	}
+
+	if (status == 0)
+	{
+		records        = (const BinaryRecord*)(header + 1);
+		strings        = (const char*)(records + header->count);
+		report->binary = true;
+
+		for (i = 0; status == 0 && i < header->count; ++i)
+		{
+			if ((uint64_t)records[i].titleOffset + records[i].titleLength > header->stringTableSize ||
+			    (uint64_t)records[i].genreOffset + records[i].genreLength > header->stringTableSize)
+			{
+				status = EILSEQ;
+				break;
+			}
+
+			issue = checkMovieFields(records[i].titleLength, records[i].genreLength, records[i].duration);
+
+			if (issue >= 0)
+			{
+				status = noteIngestIssue(report, (IngestIssue)issue, report->records++, strings + records[i].titleOffset, records[i].titleLength, true);
+				continue;
+			}
+
+			++report->records;
+
+			movie = createMovieNodeFromBytes(pool, strings + records[i].titleOffset, (int)records[i].titleLength,
+			                                 strings + records[i].genreOffset, (int)records[i].genreLength, records[i].duration);
+
+			if (movie == NULL)
+			{
+				status = errno;
+			}
+			else if (indexed)
+			{
+				status = appendMovie(list, movie);
+			}
+			else
+			{
+				linkMovie(list, movie);
+			}
+		}
+	}
+
+	if (status != 0 && indexed)
+	{
+		deleteList(list);
+		errno = status;
+	}
+
+	unmapFile(&mapping);
+
+	return status;
+}
+
+/*
+// Formats a given linked list of Movies as the contents of a binary file: the header, the records
+// and the string table, assembled in one buffer so the file is written with one call.
+//
+// [in]  list - The linked list of Movies
+// [out] data - The contents, to be freed by the caller
+// [out] size - The size of the contents
+//
+// Returns error status code.
+*/
+int formatMovieListBinary(MovieList* list, char** data, size_t* size)
+{
+	int           status     = 0;
+	BinaryHeader  header     = {0};
+	BinaryRecord* records    = NULL;
+	char*         strings    = NULL;
+	size_t        stringSize = 0;
+	size_t        offset     = 0;
+	size_t        length     = 0;
+	Movie*        itr        = NULL;
+	uint32_t      i          = 0;
+
+	if (status == 0)
+	{
+		for (itr = list->head; itr != NULL; itr = getMovie(itr->next))
+		{
+			stringSize += strlen(itr->title) + strlen(getGenreName(itr->genreId));
+		}
+
+		*size = sizeof(header) + list->count * sizeof(BinaryRecord) + stringSize;
+		*data = malloc(*size);
+
+		if (*data == NULL)
+		{
+			status = ENOMEM;
+		}
+	}
+
+	if (status == 0)
+	{
+		records = (BinaryRecord*)(*data + sizeof(header));
+		strings = (char*)(records + list->count);
+
+		for (itr = list->head, i = 0; itr != NULL; itr = getMovie(itr->next), ++i)
+		{
+			length = strlen(itr->title);
+			memcpy(strings + offset, itr->title, length);
+			records[i].titleOffset = (uint32_t)offset;
+			records[i].titleLength = (uint32_t)length;
+			offset += length;
+
+			length = strlen(getGenreName(itr->genreId));
+			memcpy(strings + offset, getGenreName(itr->genreId), length);
+			records[i].genreOffset = (uint32_t)offset;
+			records[i].genreLength = (uint32_t)length;
+			offset += length;
+
+			records[i].duration = itr->duration;
+		}
+
+		memcpy(header.magic, BINARY_FILE_MAGIC, sizeof(header.magic));
+		header.version         = BINARY_FILE_VERSION;
+		header.byteOrder       = BINARY_BYTE_ORDER;
+		header.count           = (uint32_t)list->count;
+		header.stringTableSize = stringSize;
+
+		memcpy(*data, &header, sizeof(header));
+	}
+
+	return status;
+}
+
+/*=========================================================================================================
+// Library Snapshots
+//=======================================================================================================*/
+
+#define LIBRARY_SNAPSHOT_SUFFIX  ".snap"
+#define LIBRARY_SNAPSHOT_MAGIC   "MWLS"
+#define LIBRARY_SNAPSHOT_VERSION 1
+
+/*
+// Header of a library snapshot: a loaded library together with its title index and title search
+// index, stamped with the size and modification time of the library file it was loaded from. The
+// header is followed by
+//
+//   SnapshotRecord records[count]                  in list order
+//   uint32_t       titleSlots[titleCapacity]       list position + 1 of each title index slot, or 0
+//   uint32_t       sorted[count]                   see TitleSearchIndex
+//   uint32_t       trigramKeys[trigramCount]
+//   uint32_t       trigramStarts[trigramCount + 1]
+//   uint32_t       postings[postingCount]
+//   uint32_t       genreOffsets[genreCount]        by genre id, into the genre names
+//   char           titles[titleBytes]              null-terminated, in list order
+//   char           genres[genreBytes]              null-terminated
+*/
+typedef struct SnapshotHeader
+{
+	char     magic[4];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint32_t count;
+	uint64_t sourceSize;
+	int64_t  sourceTime;     /* see getFileStamp */
+	uint64_t checksum;       /* of everything after the header, see checksumBytes */
+	double   duration;       /* the list's running total, see trackDuration */
+	double   durationCompensation;
+	uint32_t titleCapacity;
+	uint32_t trigramCount;
+	uint32_t postingCount;
+	uint32_t genreCount;
+	uint64_t titleBytes;
+	uint64_t genreBytes;
+} SnapshotHeader;
+
+/*
+// A Movie of a library snapshot.
+*/
+typedef struct SnapshotRecord
+{
+	double   duration;     /* hours */
+	uint32_t titleOffset;  /* into the titles */
+	uint32_t titleHash;
+	uint16_t genreId;      /* into the genre offsets */
+	uint8_t  titleLength;
+	uint8_t  reserved[5];
+} SnapshotRecord;
+
+/*
+// Reads the size and last modification time of a given file, which together tell whether it has
+// changed since a snapshot of it was taken.
+//
+// [in]  fileName - The name of the file
+// [out] size     - The size of the file in bytes
+// [out] time     - The modification time, in nanoseconds (100 ns units on Windows), fine enough
+//                  to tell apart rewrites within the same second
+//
+// Returns error status code.
+*/
+int getFileStamp(const char* fileName, uint64_t* size, int64_t* time)
+{
+	int status = 0;
+
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA info;
+
+	if (!GetFileAttributesExA(fileName, GetFileExInfoStandard, &info))
+	{
+		status = GetLastError() == ERROR_FILE_NOT_FOUND ? ENOENT : EIO;
+	}
+	else
+	{
+		*size = (uint64_t)info.nFileSizeHigh << 32 | info.nFileSizeLow;
+		*time = (int64_t)((uint64_t)info.ftLastWriteTime.dwHighDateTime << 32 | info.ftLastWriteTime.dwLowDateTime);
+	}
+#else
+	struct stat info;
+
+	if (stat(fileName, &info) != 0)
+	{
+		status = errno;
+	}
+	else
+	{
+		*size = (uint64_t)info.st_size;
+#ifdef __APPLE__
+		/* _POSIX_C_SOURCE selects the POSIX field names, where st_mtimespec is split in two */
+		*time = (int64_t)info.st_mtime * 1000000000 + info.st_mtimensec;
+#else
+		*time = (int64_t)info.st_mtim.tv_sec * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+	}
+#endif
+
+	return status;
+}
+
+/*
+// Computes a 64-bit checksum of a given buffer. Words are mixed in four independent lanes, so it
+// runs at memory speed where hashBytes, one dependent multiply per byte, would take longer than
+// the rest of a snapshot load.
+//
+// [in] data - The buffer
+// [in] size - The size of the buffer
+//
+// Returns the checksum.
+*/
+uint64_t checksumBytes(const char* data, size_t size)
+{
+	const uint64_t prime1   = 0x9E3779B185EBCA87ull;
+	const uint64_t prime2   = 0xC2B2AE3D27D4EB4Full;
+	uint64_t       lanes[4] = {prime1, prime2, ~prime1, ~prime2};
+	uint64_t       checksum = size;
+	uint64_t       word     = 0;
+	size_t         i        = 0;
+	int            j        = 0;
+
+	for (i = 0; i + 32 <= size; i += 32)
+	{
+		for (j = 0; j < 4; ++j)
+		{
+			memcpy(&word, data + i + j * 8, sizeof(word));
+			lanes[j] += word * prime2;
+			lanes[j]  = (lanes[j] << 31 | lanes[j] >> 33) * prime1;
+		}
+	}
+
+	for (; i < size; ++i)
+	{
+		checksum = (checksum ^ (unsigned char)data[i]) * prime1;
+	}
+
+	for (j = 0; j < 4; ++j)
+	{
+		checksum  = (checksum ^ lanes[j]) * prime2;
+		checksum ^= checksum >> 29;
+	}
+
+	return checksum;
+}
+
+/*
+// Returns the size of the library snapshot a given header describes, see SnapshotHeader. The title
+// and genre byte counts must already be known to be at most the size of the file.
+//
+// [in] header - The snapshot header
+*/
+uint64_t getSnapshotSize(const SnapshotHeader* header)
+{
+	uint64_t words = (uint64_t)header->titleCapacity + header->count + header->trigramCount + header->trigramCount + 1 +
+	                 header->postingCount + header->genreCount;
+
+	return sizeof(SnapshotHeader) + (uint64_t)header->count * sizeof(SnapshotRecord) + words * sizeof(uint32_t) +
+	       header->titleBytes + header->genreBytes;
+}
+
+/*
+// Formats a given library and its title and title search indexes as the contents of a snapshot,
+// assembled in one buffer so the file is written with one call, see loadLibrarySnapshot.
+//
+// [in]  library    - The fully loaded library, whose search index is current
+// [in]  sourceSize - The size of the library file, see getFileStamp
+// [in]  sourceTime - The modification time of the library file
+// [out] data       - The contents, to be freed by the caller
+// [out] size       - The size of the contents
+//
+// Returns error status code.
+*/
+int formatLibrarySnapshot(MovieList* library, uint64_t sourceSize, int64_t sourceTime, char** data, size_t* size)
+{
+	int                     status       = 0;
+	SnapshotHeader          header       = {0};
+	const TitleSearchIndex* index        = library->searchIndex;
+	const TitleIndex*       titleIndex   = &library->titleIndex;
+	SnapshotRecord*         records      = NULL;
+	uint32_t*               slots        = NULL;
+	uint32_t*               sorted       = NULL;
+	uint32_t*               keys         = NULL;
+	uint32_t*               starts       = NULL;
+	uint32_t*               postings     = NULL;
+	uint32_t*               genreOffsets = NULL;
+	char*                   titles       = NULL;
+	char*                   genres       = NULL;
+	size_t                  offset       = 0;
+	size_t                  length       = 0;
+	unsigned int            slot         = 0;
+	Movie*                  itr          = NULL;
+	uint32_t                i            = 0;
+
+	*data = NULL;
+
+	/*
+	// The search index titles are laid out like the snapshot's, so they must still match the list:
+	*/
+	if (library->catalog != NULL || !isTitleSearchIndexCurrent(library) || index->extraCount != 0 ||
+	    index->count != library->count || titleIndex->count != (unsigned int)library->count)
+	{
+		status = EINVAL;
+	}
+
+	if (status == 0)
+	{
+		for (itr = library->head; itr != NULL; itr = getMovie(itr->next))
+		{
+			header.titleBytes += itr->titleLength + 1;
+		}
+
+		for (i = 0; i < (uint32_t)genreTable.count; ++i)
+		{
+			header.genreBytes += strlen(genreTable.names[i]) + 1;
+		}
+
+		header.count         = (uint32_t)library->count;
+		header.titleCapacity = titleIndex->capacity;
+		header.trigramCount  = (uint32_t)index->trigramCount;
+		header.postingCount  = index->trigramStarts[index->trigramCount];
+		header.genreCount    = (uint32_t)genreTable.count;
+
+		*size = (size_t)getSnapshotSize(&header);
+		*data = calloc(1, *size);
+
+		if (*data == NULL)
+		{
+			status = ENOMEM;
+		}
+	}
+
+	if (status == 0)
+	{
+		records      = (SnapshotRecord*)(*data + sizeof(header));
+		slots        = (uint32_t*)(records + header.count);
+		sorted       = slots + header.titleCapacity;
+		keys         = sorted + header.count;
+		starts       = keys + header.trigramCount;
+		postings     = starts + header.trigramCount + 1;
+		genreOffsets = postings + header.postingCount;
+		titles       = (char*)(genreOffsets + header.genreCount);
+		genres       = titles + header.titleBytes;
+
+		for (itr = library->head, i = 0; status == 0 && itr != NULL; itr = getMovie(itr->next), ++i)
+		{
+			if (strcmp(index->titles + offset, itr->title) != 0)
+			{
+				status = EINVAL;
+			}
+
+			length = itr->titleLength;
+			memcpy(titles + offset, itr->title, length + 1);
+
+			records[i].duration    = itr->duration;
+			records[i].titleOffset = (uint32_t)offset;
+			records[i].titleHash   = itr->titleHash;
+			records[i].genreId     = itr->genreId;
+			records[i].titleLength = (uint8_t)length;
+			offset += length + 1;
+
+			for (slot = itr->titleHash & (titleIndex->capacity - 1); titleIndex->slots[slot] != itr; slot = (slot + 1) & (titleIndex->capacity - 1))
+			{
+			}
+
+			slots[slot] = i + 1;
+		}
+	}
+
+	if (status == 0)
+	{
+		memcpy(sorted, index->sorted, header.count * sizeof(uint32_t));
+		memcpy(keys, index->trigramKeys, header.trigramCount * sizeof(uint32_t));
+		memcpy(starts, index->trigramStarts, (header.trigramCount + 1) * sizeof(uint32_t));
+		memcpy(postings, index->postings, header.postingCount * sizeof(uint32_t));
+
+		for (i = 0, offset = 0; i < header.genreCount; ++i)
+		{
+			length = strlen(genreTable.names[i]) + 1;
+			memcpy(genres + offset, genreTable.names[i], length);
+			genreOffsets[i] = (uint32_t)offset;
+			offset += length;
+		}
+
+		memcpy(header.magic, LIBRARY_SNAPSHOT_MAGIC, sizeof(header.magic));
+		header.version              = LIBRARY_SNAPSHOT_VERSION;
+		header.byteOrder            = BINARY_BYTE_ORDER;
+		header.sourceSize           = sourceSize;
+		header.sourceTime           = sourceTime;
+		header.duration             = library->duration;
+		header.durationCompensation = library->durationCompensation;
+		header.checksum             = checksumBytes(*data + sizeof(header), *size - sizeof(header));
+
+		memcpy(*data, &header, sizeof(header));
+	}
+
+	if (status != 0)
+	{
+		free(*data);
+		*data = NULL;
+	}
+
+	return status;
+}
+
+/*
+// Checks that the sections of a given mapped library snapshot stay within their bounds, so a
+// snapshot that passed its checksum cannot make a load read out of bounds.
+//
+// [in] header - The mapped snapshot
+//
+// Returns error status code.
+*/
+int checkLibrarySnapshot(const SnapshotHeader* header)
+{
+	int                   status       = 0;
+	const SnapshotRecord* records      = (const SnapshotRecord*)(header + 1);
+	const uint32_t*       slots        = (const uint32_t*)(records + header->count);
+	const uint32_t*       sorted       = slots + header->titleCapacity;
+	const uint32_t*       starts       = sorted + header->count + header->trigramCount;
+	const uint32_t*       postings     = starts + header->trigramCount + 1;
+	const uint32_t*       genreOffsets = postings + header->postingCount;
+	const char*           titles       = (const char*)(genreOffsets + header->genreCount);
+	const char*           genres       = titles + header->titleBytes;
+	uint32_t              filled       = 0;
+	uint32_t              i            = 0;
+
+	if (header->count > INT32_MAX || header->titleCapacity == 0 || (header->titleCapacity & (header->titleCapacity - 1)) != 0 ||
+	    (uint64_t)header->count * 10 > (uint64_t)header->titleCapacity * 7 || header->genreCount > MAX_GENRE_COUNT ||
+	    (header->titleBytes != 0 && titles[header->titleBytes - 1] != '\0') ||
+	    (header->genreBytes != 0 && genres[header->genreBytes - 1] != '\0') ||
+	    starts[0] != 0 || starts[header->trigramCount] != header->postingCount)
+	{
+		status = EILSEQ;
+	}
+
+	for (i = 0; status == 0 && i < header->count; ++i)
+	{
+		if ((uint64_t)records[i].titleOffset + records[i].titleLength >= header->titleBytes ||
+		    titles[records[i].titleOffset + records[i].titleLength] != '\0' || records[i].genreId >= header->genreCount ||
+		    sorted[i] >= header->titleBytes)
+		{
+			status = EILSEQ;
+		}
+	}
+
+	for (i = 0; status == 0 && i < header->titleCapacity; ++i)
+	{
+		filled += slots[i] != 0;
+		status  = slots[i] <= header->count ? 0 : EILSEQ;
+	}
+
+	for (i = 0; status == 0 && i < header->trigramCount; ++i)
+	{
+		status = starts[i] <= starts[i + 1] ? 0 : EILSEQ;
+	}
+
+	for (i = 0; status == 0 && i < header->postingCount; ++i)
+	{
+		status = postings[i] < header->count ? 0 : EILSEQ;
+	}
+
+	for (i = 0; status == 0 && i < header->genreCount; ++i)
+	{
+		if (genreOffsets[i] >= header->genreBytes || strlen(genres + genreOffsets[i]) > MAX_GENRE_LENGTH)
+		{
+			status = EILSEQ;
+		}
+	}
+
+	if (status == 0 && filled != header->count)
+	{
+		status = EILSEQ;
+	}
+
+	return status;
+}
+
+/*
+// Loads a library from a given snapshot, see formatLibrarySnapshot, provided it was taken of the
+// library file as it is now. The snapshot is mapped and its sections copied into place: nothing is
+// parsed, hashed or sorted, and the title index slots are taken as they are, so the only per-Movie
+// work left is linking the nodes and their order and genre indexes.
+//
+// [in]  fileName   - The name of the snapshot file
+// [in]  sourceSize - The size of the library file, see getFileStamp
+// [in]  sourceTime - The modification time of the library file
+// [in]  pool       - The Movie pool to allocate from
+// [out] list       - The empty linked list of Movies to fill; on error the caller deletes it
+//
+// Returns error status code; ENOENT also when the snapshot is of an older library file.
+*/
+int loadLibrarySnapshot(const char* fileName, uint64_t sourceSize, int64_t sourceTime, MoviePool* pool, MovieList* list)
+{
+	int                   status       = 0;
+	FileMapping           mapping      = {0};
+	const SnapshotHeader* header       = NULL;
+	const SnapshotRecord* records      = NULL;
+	const uint32_t*       slots        = NULL;
+	const uint32_t*       sorted       = NULL;
+	const uint32_t*       keys         = NULL;
+	const uint32_t*       starts       = NULL;
+	const uint32_t*       postings     = NULL;
+	const uint32_t*       genreOffsets = NULL;
+	const char*           titles       = NULL;
+	const char*           genres       = NULL;
+	const char*           copy         = "";
+	int*                  genreIds     = NULL;
+	Movie**               movies       = NULL;
+	Movie*                movie        = NULL;
+	TitleSearchIndex*     index        = NULL;
+	uint32_t              i            = 0;
+
+	if (status == 0)
+	{
+		status = mapFile(fileName, &mapping);
+	}
+
+	if (status == 0)
+	{
+		header = (const SnapshotHeader*)mapping.data;
+
+		if (mapping.size < sizeof(SnapshotHeader) || memcmp(header->magic, LIBRARY_SNAPSHOT_MAGIC, sizeof(header->magic)) != 0)
+		{
+			status = EILSEQ;
+		}
+		else if (header->version != LIBRARY_SNAPSHOT_VERSION || header->byteOrder != BINARY_BYTE_ORDER)
+		{
+			status = ENOTSUP;
+		}
+		else if (header->sourceSize != sourceSize || header->sourceTime != sourceTime)
+		{
+			status = ENOENT;
+		}
+		else if (header->titleBytes > mapping.size || header->genreBytes > mapping.size || getSnapshotSize(header) != mapping.size ||
+		         checksumBytes(mapping.data + sizeof(SnapshotHeader), mapping.size - sizeof(SnapshotHeader)) != header->checksum)
+		{
+			status = EILSEQ;
+		}
+		else
+		{
+			status = checkLibrarySnapshot(header);
+		}
+	}
+
+	if (status == 0)
+	{
+		records      = (const SnapshotRecord*)(header + 1);
+		slots        = (const uint32_t*)(records + header->count);
+		sorted       = slots + header->titleCapacity;
+		keys         = sorted + header->count;
+		starts       = keys + header->trigramCount;
+		postings     = starts + header->trigramCount + 1;
+		genreOffsets = postings + header->postingCount;
+		titles       = (const char*)(genreOffsets + header->genreCount);
+		genres       = titles + header->titleBytes;
+
+		genreIds               = malloc(header->genreCount * sizeof(int) + 1);
+		movies                 = malloc(header->count * sizeof(Movie*) + 1);
+		list->titleIndex.slots = calloc(header->titleCapacity, sizeof(Movie*));
+
+		/*
+		// All the titles go into the pool's string arena with one copy:
+		*/
+		if (header->titleBytes != 0)
+		{
+			copy = storeString(pool, titles, (size_t)header->titleBytes);
+		}
+
+		if (genreIds == NULL || movies == NULL || list->titleIndex.slots == NULL || copy == NULL)
+		{
+			status = ENOMEM;
+		}
+		else
+		{
+			list->titleIndex.capacity = header->titleCapacity;
+		}
+	}
+
+	for (i = 0; status == 0 && i < header->genreCount; ++i)
+	{
+		genreIds[i] = internGenre(genres + genreOffsets[i], (int)strlen(genres + genreOffsets[i]));
+
+		if (genreIds[i] < 0)
+		{
+			status = errno;
+		}
+	}
+
+	for (i = 0; status == 0 && i < header->count; ++i)
+	{
+		movie = allocateMovie(pool);
+
+		if (movie == NULL)
+		{
+			status = ENOMEM;
+		}
+		else
+		{
+			movie->title       = copy + records[i].titleOffset;
+			movie->titleLength = records[i].titleLength;
+			movie->titleHash   = records[i].titleHash;
+			movie->genreId     = (unsigned short)genreIds[records[i].genreId];
+			movie->duration    = records[i].duration;
+			movies[i]          = movie;
+
+			linkMovie(list, movie);
+		}
+	}
+
+	if (pool == &moviePool)
+	{
+		STATS_ADD(nodesCreated, list->count);
+	}
+
+	if (status == 0)
+	{
+		for (i = 0; i < header->titleCapacity; ++i)
+		{
+			list->titleIndex.slots[i] = slots[i] != 0 ? movies[slots[i] - 1] : NULL;
+		}
+
+		list->titleIndex.count     = header->count;
+		list->duration             = header->duration;
+		list->durationCompensation = header->durationCompensation;
+
+		buildOrderIndex(list);
+	}
+
+	for (i = 0; status == 0 && i < header->count; ++i)
+	{
+		status = addToGenreIndex(list, movies[i]);
+	}
+
+	/*
+	// Like a built search index, a copied one is optional; if it cannot be, the first search builds
+	// one:
+	*/
+	if (status == 0)
+	{
+		index = calloc(1, sizeof(TitleSearchIndex));
+
+		if (index != NULL)
+		{
+			index->count         = (int)header->count;
+			index->trigramCount  = (int)header->trigramCount;
+			index->titles        = malloc(header->titleBytes + 1);
+			index->sorted        = malloc(header->count * sizeof(unsigned int) + 1);
+			index->trigramKeys   = malloc(header->trigramCount * sizeof(unsigned int) + 1);
+			index->trigramStarts = malloc((header->trigramCount + 1) * sizeof(unsigned int));
+			index->postings      = malloc(header->postingCount * sizeof(unsigned int) + 1);
+
+			if (index->titles == NULL || index->sorted == NULL || index->trigramKeys == NULL || index->trigramStarts == NULL || index->postings == NULL)
+			{
+				clearTitleSearchIndex(index);
+				index = NULL;
+			}
+			else
+			{
+				memcpy(index->titles, titles, (size_t)header->titleBytes);
+				memcpy(index->sorted, sorted, header->count * sizeof(unsigned int));
+				memcpy(index->trigramKeys, keys, header->trigramCount * sizeof(unsigned int));
+				memcpy(index->trigramStarts, starts, (header->trigramCount + 1) * sizeof(unsigned int));
+				memcpy(index->postings, postings, header->postingCount * sizeof(unsigned int));
+			}
+		}
+
+		list->searchIndex = index;
+	}
+
+	free(genreIds);
+	free(movies);
+	unmapFile(&mapping);
+
+	return status;
+}
+
+/*=========================================================================================================
+// Lazy Catalog
+//=======================================================================================================*/
+
+#ifndef LAZY_CACHE_CAPACITY
+#define LAZY_CACHE_CAPACITY 4096  /* decoded library Movies kept in memory in lazy mode */
+#endif
+
+/*
+// The location of one library record in a lazily loaded library file.
+*/
+typedef struct CatalogEntry
+{
+	uint64_t     offset;  /* start of the record's title line */
+	unsigned int hash;    /* see hashTitle */
+	unsigned int taken;   /* nonzero while the record is decoded into a Movie */
+} CatalogEntry;
+
+/*
+// A library file left mapped in memory with only an index of its records, so that Movies are
+// decoded when first looked up rather than at startup. The decoded Movies live in the library list,
+// which serves as an LRU cache trimmed back to cacheCapacity by trimLibraryCache.
+*/
+typedef struct LazyCatalog
+{
+	FileMapping   mapping;
+	CatalogEntry* entries;        /* sorted by hash, then offset */
+	int           count;
+	int           available;      /* records not decoded, see getLibraryCount */
+	int           cacheCapacity;
+} LazyCatalog;
+
+int compareCatalogEntries(const void* left, const void* right)
+{
+	const CatalogEntry* a = left;
+	const CatalogEntry* b = right;
+
+	if (a->hash != b->hash)
+	{
+		return a->hash < b->hash ? -1 : 1;
+	}
+
+	return a->offset < b->offset ? -1 : a->offset > b->offset;
+}
+
+/*
+// Releases a given lazy catalog.
+//
+// [in] catalog - The lazy catalog, or NULL
+*/
+void clearLazyCatalog(LazyCatalog* catalog)
+{
+	if (catalog != NULL)
+	{
+		unmapFile(&catalog->mapping);
+		free(catalog->entries);
+		free(catalog);
+	}
+}
+
+/*
+// Counts the lines that precede a given position of a text.
+//
+// [in] begin    - The start of the text
+// [in] position - The position within the text
+*/
+int countLines(const char* begin, const char* position)
+{
+	int lines = 0;
+
+	for (begin = memchr(begin, '\n', position - begin); begin != NULL; begin = memchr(begin + 1, '\n', position - begin - 1))
+	{
+		++lines;
+	}
+
+	return lines;
+}
+
+/*
+// Determines whether two catalog entries hold the same title.
+//
+// [in] catalog - The lazy catalog
+// [in] left    - The first entry
+// [in] right   - The second entry
+*/
+bool isSameCatalogTitle(const LazyCatalog* catalog, const CatalogEntry* left, const CatalogEntry* right)
+{
+	const char* end       = catalog->mapping.data + catalog->mapping.size;
+	const char* leftText  = catalog->mapping.data + left->offset;
+	const char* rightText = catalog->mapping.data + right->offset;
+	const char* next      = NULL;
+	const char* leftEnd   = scanLine(leftText, end, &next);
+	const char* rightEnd  = scanLine(rightText, end, &next);
+
+	return left->hash == right->hash && leftEnd - leftText == rightEnd - rightText && memcmp(leftText, rightText, leftEnd - leftText) == 0;
+}
+
+/*
+// Maps a given library text file and indexes the title of every record without decoding any.
+// Records are still validated the way loadMovieLibrary validates them, so both modes accept the
+// same records, and of several records with one title only the first is kept.
+//
+// [in]  fileName - The name of the library text file
+// [out] catalog  - The lazy catalog, to be released with clearLazyCatalog
+// [out] report   - The empty ingest report to fill
+//
+// Returns error status code.
+*/
+int openLazyCatalog(const char* fileName, LazyCatalog** catalog, IngestReport* report)
+{
+	int           status   = 0;
+	LazyCatalog*  result   = NULL;
+	CatalogEntry* entries  = NULL;
+	int           capacity = 0;
+	const char*   end      = NULL;
+	const char*   itr      = NULL;
+	const char*   blank    = NULL;
+	const char*   title    = NULL;
+	const char*   titleEnd = NULL;
+	const char*   genre    = NULL;
+	const char*   genreEnd = NULL;
+	const char*   line     = NULL;
+	const char*   lineEnd  = NULL;
+	int           issue    = -1;
+	double        duration = 0.0;
+	int           first    = 0;
+	int           kept     = 0;
+	int           record   = 0;
+	int           i        = 0;
+	int           j        = 0;
+
+	if (status == 0)
+	{
+		result = calloc(1, sizeof(LazyCatalog));
+
+		if (result == NULL)
+		{
+			status = ENOMEM;
+		}
+		else
+		{
+			result->cacheCapacity = LAZY_CACHE_CAPACITY;
+			status                = mapFile(fileName, &result->mapping);
+		}
+	}
+
+	if (status == 0)
+	{
+		itr = result->mapping.data;
+		end = itr + result->mapping.size;
+
+		while (status == 0 && itr < end)
+		{
+			for (blank = itr; blank < end && (*blank == '\n' || *blank == '\r'); ++blank)
+			{
+			}
+
+			if (blank == end)
+			{
+				break;
+			}
+
+			title    = itr;
+			titleEnd = scanLine(title, end, &genre);
+			genreEnd = scanLine(genre, end, &line);
+			lineEnd  = scanLine(line, end, &itr);
+			issue    = validateMovieRecord(title, titleEnd, genre, genreEnd, line, lineEnd, &duration);
+
+			if (issue >= 0)
+			{
+				status = noteIngestIssue(report, (IngestIssue)issue, report->records++, title, titleEnd - title, true);
+				continue;
+			}
+
+			if (result->count == capacity)
+			{
+				capacity = capacity == 0 ? 1024 : capacity * 2;
+				entries  = realloc(result->entries, capacity * sizeof(CatalogEntry));
+
+				if (entries == NULL)
+				{
+					status = ENOMEM;
+				}
+				else
+				{
+					result->entries = entries;
+				}
+			}
+
+			if (status == 0)
+			{
+				result->entries[result->count].offset = (uint64_t)(title - result->mapping.data);
+				result->entries[result->count].hash   = hashBytes(title, titleEnd - title);
+				result->entries[result->count].taken  = 0;
+				++result->count;
+				++report->records;
+			}
+		}
+	}
+
+	if (status == 0)
+	{
+		qsort(result->entries, result->count, sizeof(CatalogEntry), compareCatalogEntries);
+
+		/*
+		// Sorting by hash then offset leaves each title's records together with the first of them in
+		// the file leading; drop the rest:
+		*/
+		for (i = 0, kept = 0; status == 0 && i < result->count; ++i)
+		{
+			if (i == 0 || result->entries[i].hash != result->entries[first].hash)
+			{
+				first = kept;
+			}
+
+			for (j = first; j < kept && !isSameCatalogTitle(result, &result->entries[j], &result->entries[i]); ++j)
+			{
+			}
+
+			if (j == kept)
+			{
+				result->entries[kept++] = result->entries[i];
+			}
+			else
+			{
+				title  = result->mapping.data + result->entries[i].offset;
+				record = report->exampleCount < INGEST_REPORT_EXAMPLES ? countLines(result->mapping.data, title) / 3 : 0;
+				status = noteIngestIssue(report, DuplicateTitle, record, title, scanLine(title, end, &itr) - title, false);
+			}
+		}
+
+		result->count     = kept;
+		result->available = result->count;
+	}
+
+	if (status != 0 && result != NULL)
+	{
+		clearLazyCatalog(result);
+		result = NULL;
+	}
+
+	*catalog = result;
+
+	return status;
+}
+
+/*
+// Finds the catalog entry of a given title in a given taken state.
+//
+// [in] catalog - The lazy catalog
+// [in] title   - The title
+// [in] taken   - Whether to find a decoded record or one still only in the file
+//
+// Returns the entry, or NULL if there is none.
+*/
+CatalogEntry* findCatalogEntry(LazyCatalog* catalog, const char* title, bool taken)
+{
+	CatalogEntry* entry  = NULL;
+	unsigned int  hash   = hashTitle(title);
+	size_t        length = strlen(title);
+	const char*   end    = catalog->mapping.data + catalog->mapping.size;
+	const char*   record = NULL;
+	const char*   next   = NULL;
+	int           low    = 0;
+	int           high   = catalog->count;
+	int           middle = 0;
+
+	while (low < high)
+	{
+		middle = low + (high - low) / 2;
+
+		if (catalog->entries[middle].hash < hash)
+		{
+			low = middle + 1;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	for (; entry == NULL && low < catalog->count && catalog->entries[low].hash == hash; ++low)
+	{
+		record = catalog->mapping.data + catalog->entries[low].offset;
+
+		if ((catalog->entries[low].taken != 0) == taken && (size_t)(scanLine(record, end, &next) - record) == length &&
+		    memcmp(record, title, length) == 0)
+		{
+			entry = &catalog->entries[low];
+		}
+	}
+
+	return entry;
+}
+
+/*
+// Decodes the record of a given catalog entry into a new Movie.
+//
+// [in] catalog - The lazy catalog
+// [in] entry   - The catalog entry
+//
+// Returns the Movie, or NULL on error.
+*/
+Movie* decodeCatalogEntry(LazyCatalog* catalog, CatalogEntry* entry)
+{
+	const char* end      = catalog->mapping.data + catalog->mapping.size;
+	const char* title    = catalog->mapping.data + entry->offset;
+	const char* titleEnd = NULL;
+	const char* genre    = NULL;
+	const char* genreEnd = NULL;
+	const char* line     = NULL;
+	const char* lineEnd  = NULL;
+	const char* next     = NULL;
+
+	titleEnd = scanLine(title, end, &genre);
+	genreEnd = scanLine(genre, end, &line);
+	lineEnd  = scanLine(line, end, &next);
+
+	return createMovieNodeFromBytes(&moviePool, title, (int)(titleEnd - title), genre, (int)(genreEnd - genre), parseDuration(line, lineEnd, NULL));
+}
+
+/*
+// Moves a given Movie to the end of a given linked list of Movies without touching its title or
+// genre indexes, marking it most recently used.
+//
+// [in] list  - The linked list of Movies
+// [in] movie - The Movie, which must be in the list
+*/
+void touchMovie(MovieList* list, Movie* movie)
+{
+	if (movie != list->tail)
+	{
+		if (movie->prev == 0)
+		{
+			list->head = getMovie(movie->next);
+		}
+		else
+		{
+			getMovie(movie->prev)->next = movie->next;
+		}
+
+		getMovie(movie->next)->prev = movie->prev;
+		removeFromOrderIndex(list, movie);
+
+		movie->prev       = getMovieId(list->tail);
+		movie->next       = 0;
+		list->tail->next  = getMovieId(movie);
+		list->tail        = movie;
+		addToOrderIndex(list, movie, list->count - 1);
+
+		++list->revision;
+	}
+}
+
+/*
+// Searches a given library for a Movie by its given title. In a lazy library a title that has not
+// been decoded yet is decoded from the file and added to the library.
+//
+// [in] library - The library of Movies
+// [in] title   - The title of the Movie to search for
+//
+// Returns the Movie if found, or NULL if not.
+*/
+Movie* findLibraryMovie(MovieList* library, const char* title)
+{
+	Movie*        movie = searchByTitle(library, title);
+	CatalogEntry* entry = NULL;
+
+	if (library != NULL && library->catalog != NULL && title != NULL)
+	{
+		if (movie != NULL)
+		{
+			touchMovie(library, movie);
+		}
+		else if ((entry = findCatalogEntry(library->catalog, title, false)) != NULL)
+		{
+			movie = decodeCatalogEntry(library->catalog, entry);
+
+			if (movie != NULL && appendMovie(library, movie) != 0)
+			{
+				releaseMovie(&moviePool, movie);
+				movie = NULL;
+			}
+
+			if (movie != NULL)
+			{
+				entry->taken = 1;
+				--library->catalog->available;
+			}
+		}
+	}
+
+	return movie;
+}
+
+/*
+// Evicts the least recently used Movies of a given lazy library until it is back within its cache
+// capacity. Their records return to the catalog. Movies that are not from the library file cannot
+// be decoded again and are kept. This must only be called where no Movie pointers from the library
+// are held, as evicted Movies are deleted.
+//
+// [in] library - The library of Movies
+*/
+void trimLibraryCache(MovieList* library)
+{
+	Movie*        itr   = NULL;
+	Movie*        next  = NULL;
+	CatalogEntry* entry = NULL;
+
+	if (library != NULL && library->catalog != NULL)
+	{
+		for (itr = library->head; library->count > library->catalog->cacheCapacity && itr != NULL; itr = next)
+		{
+			next = getMovie(itr->next);
+
+			if ((entry = findCatalogEntry(library->catalog, itr->title, true)) != NULL)
+			{
+				entry->taken = 0;
+				++library->catalog->available;
+				deleteMovie(library, itr);
+			}
+		}
+	}
+}
+
+/*
+// Counts the Movies of a given library, including the records of a lazy library still in its file.
+//
+// [in] library - The library of Movies
+//
+// Returns the count of Movies.
+*/
+int getLibraryCount(MovieList* library)
+{
+	int count = getCount(library);
+
+	if (library != NULL && library->catalog != NULL)
+	{
+		count += library->catalog->available;
+	}
+
+	return count;
+}
+
+/*
+// Deletes a given library of Movies from memory, releasing its lazy catalog if it has one.
+//
+// [in] library - The library of Movies
+//
+// Returns 0 on success, -1 on failure.
+*/
+int deleteLibrary(MovieList* library)
+{
+	if (library != NULL)
+	{
+		clearLazyCatalog(library->catalog);
+		library->catalog = NULL;
+	}
+
+	return deleteList(library);
+}
+
+/*=========================================================================================================
+// Movie Library
+//=======================================================================================================*/
+
+/*
+// Enum of all options for adding a movie.
+*/
+typedef enum AddMovieMenuOption
+{
+	AddToBeginning = 1,
+	AddToEnd       = 2,
+	InsertWithin   = 3
+} AddMovieMenuOption;
+
+/*
+// Prints the menu for adding a movie.
+*/
+void printAddMovieMenu()
+{
+	printf("*** Add Movie Menu ***\n");
+	printf(" 1) Add to beginning\n");
+	printf(" 2) Add to end\n");
+	printf(" 3) Insert at a position\n");
+	printf("\n");
+}
+
+/*
+// Prompts for and returns a menu option for adding a movie.
+*/
+AddMovieMenuOption getAddMovieMenuOption()
+{
+	AddMovieMenuOption option = 0;
+
+	printAddMovieMenu();
+
+	option = promptForInt(1, 3, "Enter how you'd like to add: ");
+	printf("\n");
+
+	return option;
+}
+
+/*
+// Handles a single menu option for adding a movie.
+//
+// [in] option    - The menu option
+// [in] movie     - The Movie to add, from the library
+// [in] library   - The library of Movies
+// [in] watchlist - The watchlist of Movies
+//
+// Returns error status code, see transferMovie.
+*/
+int handleAddMovieMenuOption(AddMovieMenuOption option, Movie* movie, MovieList* library, MovieList* watchlist)
+{
+	int status   = 0;
+	int position = 0;
+	int count    = 0;
+
+	switch (option)
+	{
+		case AddToBeginning:
+		{
+			status = transferMovie(library, watchlist, movie, 0);
+			break;
+		}
+
+		case AddToEnd:
+		{
+			status = transferMovie(library, watchlist, movie, getCount(watchlist));
+			break;
+		}
+
+		case InsertWithin:
+		{
+			count    = getCount(watchlist);
+			position = 1;
+
+			if (count > 0)
+			{
+				printf("Enter a position from 1 to %d to add the movie: ", count);
+				printf("\n");
+				position = promptForInt(1, count, "");
+			}
+
+			status = transferMovie(library, watchlist, movie, position - 1);
+			break;
+		}
+
+		default:
+		{
+			fprintf(stderr, "Unhandled menu option for adding a movie.\n");
+			status = EINVAL;
+		}
+	}
+
+	return status;
+}
+
+/*
+// Handles menu selection and operations for adding a movie.
+//
+// [in] library   - The library of Movies
+// [in] watchlist - The watchlist of Movies
+*/
+void handleAddMovie(MovieList* library, MovieList* watchlist)
+{
+	AddMovieMenuOption option                      = 0;
+	char               title[MAX_TITLE_LENGTH + 1] = {0};
+	Movie*             movie                       = NULL;
+	int                status                      = 0;
+
+	promptFor(title, sizeof(title), "Enter the title of the movie to add: ");
+	printf("\n");
+	movie = findLibraryMovie(library, title);
+
+	if (movie != NULL)
+	{
+		option = getAddMovieMenuOption();
+
+		status = handleAddMovieMenuOption(option, movie, library, watchlist);
+
+		if (status == 0)
+		{
+			printf("%s added to the watchlist.\n", title);
+		}
+		else
+		{
+			printf("%s could not be added to the watchlist: %s\n", title, strerror(status));
+		}
+
+		printf("\n");
+	}
+	else
+	{
+		printf("%s not found in the library. Please search for movies before attempting to add.\n", title);
+		printf("\n");
+	}
+}
+
+/*
+// Enum of all library menu options.
+*/
+typedef enum LibraryMenuOption
+{
+	ViewAllMovies       = 1,
+	SearchLibrary       = 2,
+	AddMovieToWatchlist = 3,
+	ShowStatistics      = 4,
+	BrowseByGenre       = 5,
+	SearchByPrefix      = 6,
+	SearchByPartial     = 7,
+	ViewSortedMovies    = 8,
+	ShowLongestMovies   = 9,
+	ListDurationRange   = 10,
+	BackToWatchlist     = 11
+} LibraryMenuOption;
+
+/*
+// Reads a given library file into a linked list of Movies without indexing it. Text files are
+// memory-mapped and parsed in place, on one thread per PARALLEL_LOAD_MIN_BYTES up to a given count;
+// text that cannot be mapped (e.g. a pipe) is streamed, see readMovieRecords. Files ending in
+// BINARY_FILE_EXTENSION are read in the binary format.
+//
+// [in]  fileName   - The name of the library file
+// [in]  maxWorkers - The most threads to parse with
+// [in]  pool       - The Movie pool to allocate from
+// [out] list       - The empty linked list of Movies to fill; on error the caller deletes it
+// [out] report     - The empty ingest report to fill
+//
+// Returns error status code.
+*/
+int readLibraryFile(char* fileName, int maxWorkers, MoviePool* pool, MovieList* list, IngestReport* report)
+{
+	int         status      = 0;
+	FileMapping mapping     = {0};
+	FILE*       input       = NULL;
+	int         workerCount = 0;
+
+	if (isBinaryFileName(fileName))
+	{
+		status = loadMovieListBinary(fileName, pool, list, false, report);
+	}
+	else if (mapFile(fileName, &mapping) == 0)
+	{
+		workerCount = (int)(mapping.size / PARALLEL_LOAD_MIN_BYTES);
+		workerCount = workerCount < maxWorkers ? workerCount : maxWorkers;
+
+		if (workerCount > 1)
+		{
+			status = parseMovieRecordsParallel(mapping.data, mapping.data + mapping.size, workerCount, pool, list, report);
+		}
+		else
+		{
+			status = parseMovieRecords(mapping.data, mapping.data + mapping.size, pool, list, false, report);
+		}
+
+		unmapFile(&mapping);
+	}
+	else
+	{
+		input = fopen(fileName, "rb");
+
+		if (input == NULL)
+		{
+			status = errno;
+		}
+		else
+		{
+			status = readMovieRecords(input, pool, list, report);
+
+			STATS_ADD_FILE(bytesRead, input);
+			fclose(input);
+		}
+	}
+
+	return status;
+}
+
+/*
+// Reads a given library file and stores the contents as a linked list of Movies, see
+// readLibraryFile, parsing on up to one thread per processor. The title search index is built
+// once the library is loaded. Invalid records and duplicate titles are dropped and reported, see
+// IngestReport.
+//
+// [in]  fileName - The name of the library file
+// [out] library  - The linked list of Movies
+// [out] report   - The empty ingest report to fill
+//
+// Returns error status code.
+*/
+int loadMovieLibrary(char* fileName, MovieList* library, IngestReport* report)
+{
+	int status = 0;
+
+	initMovieList(library);
+
+	if (fileName == NULL)
+	{
+		status = EINVAL;
+	}
+
+	if (status == 0)
+	{
+		status = readLibraryFile(fileName, getProcessorCount(), &moviePool, library, report);
+	}
+
+	if (status == 0)
+	{
+		status = indexMovieList(library, report);
+	}
+
+	if (status != 0)
+	{
+		deleteList(library);
+		errno = status;
+	}
+	else
+	{
+		/*
+		// Build the search index up front; if that fails, the first search retries it:
+		*/
+		library->searchIndex = buildTitleSearchIndex(library);
+	}
+
+	return status;
+}
+
+/*
+// Loads a given library file like loadMovieLibrary, through a snapshot of the loaded library and
+// its indexes kept next to it under LIBRARY_SNAPSHOT_SUFFIX: while the file is unchanged its
+// snapshot is loaded instead, see loadLibrarySnapshot. Otherwise the file is loaded and a new
+// snapshot written; failing to write one is reported but does not fail the load. The file is
+// stamped before it is read, so a change made during the load only costs the next start a reload.
+// Records dropped at load are reported by the load that writes the snapshot.
+//
+// [in]  fileName - The name of the library file
+// [out] library  - The linked list of Movies
+// [out] report   - The empty ingest report to fill
+//
+// Returns error status code.
+*/
+int loadMovieLibraryWithSnapshot(char* fileName, MovieList* library, IngestReport* report)
+{
+	int      status       = 0;
+	int      saveStatus   = 0;
+	char*    snapshotName = NULL;
+	uint64_t size         = 0;
+	int64_t  time         = 0;
+	char*    data         = NULL;
+	size_t   dataSize     = 0;
+
+	initMovieList(library);
+
+	if (fileName == NULL)
+	{
+		status = EINVAL;
+	}
+
+	if (status == 0)
+	{
+		snapshotName = getSuffixedName(fileName, LIBRARY_SNAPSHOT_SUFFIX);
+		status       = snapshotName == NULL ? ENOMEM : getFileStamp(fileName, &size, &time);
+	}
+
+	if (status == 0 && loadLibrarySnapshot(snapshotName, size, time, &moviePool, library) != 0)
+	{
+		deleteList(library);
+
+		status = loadMovieLibrary(fileName, library, report);
+
+		if (status == 0)
+		{
+			saveStatus = formatLibrarySnapshot(library, size, time, &data, &dataSize);
+
+			if (saveStatus == 0)
+			{
+				saveStatus = replaceFile(snapshotName, data, dataSize);
+			}
+
+			if (saveStatus != 0)
+			{
+				fprintf(stderr, "%s: %s\n", snapshotName, strerror(saveStatus));
+			}
+		}
+	}
+
+	if (status != 0)
+	{
+		errno = status;
+	}
+
+	free(data);
+	free(snapshotName);
+
+	return status;
+}
+
+/*
+// State for the load of one of several library files, see loadMovieLibraries.
+*/
+typedef struct LibraryLoad
+{
+	Thread        thread;
+	char*         fileName;
+	int           catalog;
+	int           workerCount;
+	MoviePool     pool;
+	MovieList     list;
+	IngestReport* report;
+	bool          started;
+	int           status;
+} LibraryLoad;
+
+/*
+// Reads one library file into its own list and pool, see readLibraryFile, and tags its Movies with
+// its catalog.
+//
+// [in] load - The LibraryLoad
+*/
+void loadLibraryWorker(void* load)
+{
+	LibraryLoad* self = load;
+	Movie*       itr  = NULL;
+
+	self->status = readLibraryFile(self->fileName, self->workerCount, &self->pool, &self->list, self->report);
+
+	for (itr = self->list.head; itr != NULL; itr = getMovie(itr->next))
+	{
+		itr->catalog = (unsigned char)self->catalog;
+	}
+}
+
+/*
+// Reads several library files at once, each on its own thread, into one library whose title index
+// spans them all, so a lookup is one probe however many files there are. Every Movie records the
+// file it came from, see getCatalogName, and a title found in more than one file is kept from the
+// first file listed.
+//
+// [in]  fileNames - The names of the library files
+// [in]  fileCount - The count of library files, at most MAX_CATALOGS
+// [out] library   - The linked list of Movies
+// [out] reports   - The empty ingest reports to fill, by catalog: reports[1] for the first file
+//
+// Returns error status code.
+*/
+int loadMovieLibraries(char** fileNames, int fileCount, MovieList* library, IngestReport* reports)
+{
+	int          status = 0;
+	LibraryLoad* loads  = NULL;
+	int          i      = 0;
+
+	initMovieList(library);
+
+	if (fileCount < 1 || fileCount > MAX_CATALOGS)
+	{
+		status = E2BIG;
+	}
+
+	if (status == 0)
+	{
+		loads = calloc(fileCount, sizeof(LibraryLoad));
+
+		if (loads == NULL)
+		{
+			status = ENOMEM;
+		}
+	}
+
+	for (i = 0; status == 0 && i < fileCount; ++i)
+	{
+		loads[i].fileName    = fileNames[i];
+		loads[i].catalog     = addCatalog(fileNames[i]);
+		loads[i].workerCount = getProcessorCount() / fileCount > 1 ? getProcessorCount() / fileCount : 1;
+		loads[i].report      = &reports[loads[i].catalog];
+
+		initMovieList(&loads[i].list);
+	}
+
+	if (status == 0)
+	{
+		/*
+		// The calling thread loads the first file itself:
+		*/
+		for (i = 1; i < fileCount; ++i)
+		{
+			loads[i].started = startThread(&loads[i].thread, loadLibraryWorker, &loads[i]) == 0;
+
+			if (!loads[i].started)
+			{
+				loadLibraryWorker(&loads[i]);
+			}
+		}
+
+		loadLibraryWorker(&loads[0]);
+
+		for (i = 0; i < fileCount; ++i)
+		{
+			if (loads[i].started)
+			{
+				joinThread(&loads[i].thread);
+			}
+
+			STATS_ADD(nodesCreated, loads[i].pool.liveCount);
+			mergeMoviePool(&moviePool, &loads[i].pool);
+
+			if (loads[i].status != 0 && status == 0)
+			{
+				status = loads[i].status;
+			}
+
+			linkMovieChain(library, &loads[i].list);
+		}
+	}
+
+	if (status == 0)
+	{
+		status = indexMovieList(library, reports);
+	}
+
+	if (status != 0)
+	{
+		deleteList(library);
+		errno = status;
+	}
+	else
+	{
+		library->searchIndex = buildTitleSearchIndex(library);
+	}
+
+	free(loads);
+
+	return status;
+}
+
+/*
+// Opens a given library text file lazily: only the location and title hash of each record are read
+// up front, and findLibraryMovie decodes Movies as they are looked up, see Lazy Catalog. Binary
+// libraries are already compact and are loaded in full.
+//
+// [in]  fileName - The name of the library text file
+// [out] library  - The linked list of Movies
+// [out] report   - The empty ingest report to fill
+//
+// Returns error status code.
+*/
+int loadMovieLibraryLazy(char* fileName, MovieList* library, IngestReport* report)
+{
+	int status = 0;
+
+	if (fileName == NULL || isBinaryFileName(fileName))
+	{
+		status = loadMovieLibrary(fileName, library, report);
+	}
+	else
+	{
+		initMovieList(library);
+
+		status = openLazyCatalog(fileName, &library->catalog, report);
+	}
+
+	return status;
+}
+
+/*
+// Prints the library menu.
+*/
+void printLibraryMenu()
+{
+	printf("*** Library Menu ***\n");
+	printf(" 1) View all movies\n");
+	printf(" 2) Search by title\n");
+	printf(" 3) Add a movie to watchlist\n");
+	printf(" 4) Show duration statistics\n");
+	printf(" 5) Browse by genre\n");
+	printf(" 6) Search by title prefix\n");
+	printf(" 7) Search by partial title\n");
+	printf(" 8) View movies sorted\n");
+	printf(" 9) Show the longest movies\n");
+	printf("10) List movies by duration range\n");
+	printf("11) Back to watchlist\n");
+	printf("\n");
+}
+
+/*
+// Prompts for and returns a library menu option choice.
+*/
+LibraryMenuOption getLibraryMenuOption()
+{
+	LibraryMenuOption option = 0;
+
+	printLibraryMenu();
+
+	option = promptForInt(1, 11, "Enter a menu choice: ");
+	printf("\n");
+
+	return option;
+}
+
+/*
+// Prints given search results a page at a time, prompting for the page to show next.
+//
+// [in] movies - The matching Movies
+// [in] count  - The count of matching Movies
+*/
+void printSearchResults(Movie** movies, int count)
+{
+	int pageCount = (count + SEARCH_PAGE_SIZE - 1) / SEARCH_PAGE_SIZE;
+	int page      = 1;
+	int i         = 0;
+
+	if (count <= 0)
+	{
+		printf("No matching movies found in the library.\n");
+		printf("\n");
+	}
+
+	while (page > 0 && count > 0)
+	{
+		printf("%d matching movies, page %d of %d:\n", count, page, pageCount);
+
+		for (i = (page - 1) * SEARCH_PAGE_SIZE; i < count && i < page * SEARCH_PAGE_SIZE; ++i)
+		{
+			printMovie(movies[i]);
+		}
+		printf("\n");
+
+		page = pageCount > 1 ? promptForInt(0, pageCount, "Enter a page to show, or 0 to stop: ") : 0;
+
+		if (page > 0)
+		{
+			printf("\n");
+		}
+	}
+}
+
+//
+// Handles a single library menu option.
+//
+// [in] option    - The library menu option
+// [in] library   - The library of Movies
+// [in] watchlist - The watchlist of Movies
+//
+void handleLibraryMenuOption(LibraryMenuOption option, MovieList* library, MovieList* watchlist)
+{
+	char               title[MAX_TITLE_LENGTH + 1] = {0};
+	char               genre[35]                   = {0};
+	int                genreId                     = 0;
+	GenreBucket*       bucket                      = NULL;
+	Movie*             itr                         = NULL;
+	MovieColumns*      columns                     = NULL;
+	DurationStatistics statistics                  = {0};
+	double             low                         = 0.0;
+	double             high                        = 0.0;
+	Movie**            matches                     = NULL;
+	int                matchCount                  = 0;
+	SortedView*        view                        = NULL;
+	int                i                           = 0;
+
+	if (library->catalog != NULL && option != SearchLibrary && option != AddMovieToWatchlist)
+	{
+		printf("Lazy library: only the %d movies looked up so far are shown, %d more are in the file.\n", getCount(library), library->catalog->available);
+		printf("\n");
+	}
+
+	switch (option)
+	{
+		case ViewAllMovies:
+		{
+			printMoviePages(library);
+			break;
+		}
+
+		case SearchLibrary:
+		{
+			promptFor(title, sizeof(title), "Enter a title to search: ");
+			printf("\n");
+
+			if (findLibraryMovie(library, title) != NULL)
+			{
+				printf("%s found in the library.\n", title);
+				printf("\n");
+			}
+			else
+			{
+				printf("%s not found in the library.\n", title);
+				printf("\n");
+			}
+			break;
+		}
+
+		case AddMovieToWatchlist:
+		{
+			pageBreak();
+
+			handleAddMovie(library, watchlist);
+			break;
+		}
+
+		case ShowStatistics:
+		{
+			columns = getMovieColumns(library);
+
+			if (columns == NULL || columns->count == 0)
+			{
+				printf("The library is empty.\n");
+				printf("\n");
+				break;
+			}
+
+			computeColumnsStatistics(columns, &statistics);
+
+			printf("Movies:   %d\n", statistics.count);
+			printf("Total:    %.2f hours\n", statistics.total);
+			printf("Shortest: %.2f hours\n", statistics.minimum);
+			printf("Longest:  %.2f hours\n", statistics.maximum);
+			printf("Average:  %.2f hours\n", statistics.average);
+			printf("\n");
+
+			low  = promptForDouble(0.0, statistics.maximum, "Enter the shortest duration to count in hours: ");
+			high = promptForDouble(low, 1e9, "Enter the longest duration to count in hours: ");
+			printf("\n");
+
+			printf("%d movies are between %.2f and %.2f hours.\n", countDurationsBetween(columns->durations, columns->count, low, high), low, high);
+			printf("\n");
+			break;
+		}
+
+		case BrowseByGenre:
+		{
+			for (genreId = 0; genreId < library->genreBucketCount; ++genreId)
+			{
+				if ((bucket = getGenreBucket(library, genreId)) != NULL)
+				{
+					printf("%s (%d movies, %.2f hours)\n", getGenreName(genreId), bucket->count, bucket->duration + bucket->durationCompensation);
+				}
+			}
+			printf("\n");
+
+			promptFor(genre, sizeof(genre), "Enter a genre to browse: ");
+			printf("\n");
+
+			bucket = getGenreBucket(library, findGenreId(genre, hashTitle(genre)));
+
+			if (bucket != NULL)
+			{
+				for (itr = bucket->head; itr != NULL; itr = getMovie(itr->genreNext))
+				{
+					printMovie(itr);
+				}
+				printf("\n");
+			}
+			else
+			{
+				printf("No %s movies found in the library.\n", genre);
+				printf("\n");
+			}
+			break;
+		}
+
+		case SearchByPrefix:
+		case SearchByPartial:
+		{
+			promptFor(title, sizeof(title), option == SearchByPrefix ? "Enter the start of a title: " : "Enter part of a title: ");
+			printf("\n");
+
+			matchCount = option == SearchByPrefix ? searchByPrefix(library, title, &matches) : searchByPartialTitle(library, title, &matches);
+
+			if (matchCount < 0)
+			{
+				perror("Failed to search the library");
+				printf("\n");
+			}
+			else
+			{
+				printSearchResults(matches, matchCount);
+			}
+
+			free(matches);
+			break;
+		}
+
+		case ViewSortedMovies:
+		case ShowLongestMovies:
+		{
+			view = getSortedView(library, option == ViewSortedMovies ? promptForMovieOrder() : ByDuration);
+
+			if (view == NULL)
+			{
+				perror("Failed to sort the library");
+				printf("\n");
+			}
+			else if (option == ViewSortedMovies)
+			{
+				printSearchResults(view->movies, view->count);
+			}
+			else if (view->count > 0)
+			{
+				matchCount = promptForInt(1, view->count, "Enter how many movies to show: ");
+				printf("\n");
+
+				for (i = view->count - 1; i >= view->count - matchCount; --i)
+				{
+					printMovie(view->movies[i]);
+				}
+				printf("\n");
+			}
+			else
+			{
+				printf("The library is empty.\n");
+				printf("\n");
+			}
+			break;
+		}
+
+		case ListDurationRange:
+		{
+			low  = promptForDouble(0.0, 1e9, "Enter the shortest duration to list in hours: ");
+			high = promptForDouble(low, 1e9, "Enter the longest duration to list in hours: ");
+			printf("\n");
+
+			matchCount = findDurationsBetween(library, low, high, &matches);
+
+			if (matchCount < 0)
+			{
+				perror("Failed to sort the library");
+				printf("\n");
+			}
+			else
+			{
+				printSearchResults(matches, matchCount);
+			}
+			break;
+		}
+
+		default:
+		{
+			fprintf(stderr, "Unhandled Library option.\n");
+		}
+	}
+}
+
+/*
+// Handles library menu selection and operations.
+//
+// [in] library   - The library of Movies
+// [in] watchlist - The watchlist of Movies
+*/
+void handleLibrary(MovieList* library, MovieList* watchlist)
+{
+	LibraryMenuOption option = 0;
+
+	while (true)
+	{
+		option = getLibraryMenuOption();
+
+		if (option == BackToWatchlist)
+		{
+			break;
+		}
+
+		handleLibraryMenuOption(option, library, watchlist);
+		trimLibraryCache(library);
+
+		pageBreak();
+	}
+}
+
+/*=========================================================================================================
+// Duration Planner
+//=======================================================================================================*/
+
+#define PLAN_UNITS_PER_HOUR 100   /* durations are planned in hundredths of an hour, as printed */
+#define PLAN_MAX_HOURS      1000
+
+/*
+// Parses a given comma-separated list of genre names into a filter of genre ids.
+//
+// [in]  text   - The genre names, empty for all genres
+// [out] filter - The filter indexed by genre id, or NULL for all genres, to be freed by the caller
+//
+// Returns error status code, ENOENT if a genre is unknown.
+*/
+int parseGenreFilter(char* text, bool** filter)
+{
+	int   status = 0;
+	char* genre  = NULL;
+	char* end    = NULL;
+	int   id     = 0;
+
+	*filter = NULL;
+	text   += strspn(text, " \t");
+
+	if (*text != '\0')
+	{
+		*filter = calloc(genreTable.count + 1, sizeof(bool));
+		status  = *filter == NULL ? ENOMEM : 0;
+	}
+
+	for (genre = text; status == 0 && *genre != '\0'; genre = end)
+	{
+		end = genre + strcspn(genre, ",");
+
+		if (*end == ',')
+		{
+			*end++ = '\0';
+			end   += strspn(end, " \t");
+		}
+
+		if ((id = findGenreId(genre, hashTitle(genre))) < 0)
+		{
+			status = ENOENT;
+		}
+		else
+		{
+			(*filter)[id] = true;
+		}
+	}
+
+	if (status != 0)
+	{
+		free(*filter);
+		*filter = NULL;
+	}
+
+	return status;
+}
+
+/*
+// Converts a given duration to whole planning units, rounding up so a plan never runs over its
+// budget.
+//
+// [in] duration - The duration in hours
+//
+// Returns the count of units, or -1 if the duration cannot be planned.
+*/
+int getPlanUnits(double duration)
+{
+	double units = ceil(duration * PLAN_UNITS_PER_HOUR - 1e-6);
+
+	return units >= 1.0 && units <= (double)PLAN_MAX_HOURS * PLAN_UNITS_PER_HOUR ? (int)units : -1;
+}
+
+/*
+// Chooses the Movies of a given library that fill a given time budget as closely as possible
+// without exceeding it. This is a bounded knapsack over durations in hundredths of an hour: Movies
+// of the same length are interchangeable, so the dynamic program runs over the distinct lengths
+// in O(lengths * budget) time and O(budget) space however large the library is. Among Movies of
+// the same length the earliest in the library are chosen. A lazy library plans over the Movies it
+// has decoded.
+//
+// [in]  library - The library of Movies
+// [in]  budget  - The budget in hours
+// [in]  filter  - The genres to choose from, indexed by genre id, or NULL for all genres
+// [out] plan    - The chosen Movies, shortest first, to be freed by the caller
+//
+// Returns the count of chosen Movies, or -1 on error.
+*/
+int planDurationBudget(MovieList* library, double budget, const bool* filter, Movie*** plan)
+{
+	int     status     = 0;
+	int     count      = 0;
+	int     capacity   = budget > 0.0 ? (int)floor(fmin(budget, PLAN_MAX_HOURS) * PLAN_UNITS_PER_HOUR + 1e-6) : 0;
+	int*    starts     = NULL;
+	int*    used       = NULL;
+	int*    from       = NULL;
+	Movie** candidates = NULL;
+	Movie** scratch    = NULL;
+	Movie*  itr        = NULL;
+	int     units      = 0;
+	int     total      = 0;
+	int     best       = 0;
+	int     x          = 0;
+
+	*plan = NULL;
+
+	if (status == 0)
+	{
+		starts = calloc(capacity + 2, sizeof(int));
+		used   = calloc(capacity + 1, sizeof(int));
+		from   = calloc(capacity + 1, sizeof(int));
+
+		if (starts == NULL || used == NULL || from == NULL)
+		{
+			status = ENOMEM;
+		}
+	}
+
+	/*
+	// Bucket the candidates by length with a counting sort, keeping library order in each bucket:
+	*/
+	if (status == 0)
+	{
+		for (itr = library->head; itr != NULL; itr = getMovie(itr->next))
+		{
+			units = getPlanUnits(itr->duration);
+
+			if (units > 0 && units <= capacity && (filter == NULL || filter[itr->genreId]))
+			{
+				++starts[units + 1];
+				++total;
+			}
+		}
+
+		for (units = 1; units <= capacity; ++units)
+		{
+			starts[units + 1] += starts[units];
+		}
+
+		candidates = malloc(total * sizeof(Movie*) + 1);
+		status     = candidates == NULL ? ENOMEM : 0;
+	}
+
+	if (status == 0)
+	{
+		for (itr = library->head; itr != NULL; itr = getMovie(itr->next))
+		{
+			units = getPlanUnits(itr->duration);
+
+			if (units > 0 && units <= capacity && (filter == NULL || filter[itr->genreId]))
+			{
+				candidates[starts[units]++] = itr;
+			}
+		}
+
+		/*
+		// Placing shifted every start to the next bucket's; shift them back:
+		*/
+		for (units = capacity; units > 0; --units)
+		{
+			starts[units] = starts[units - 1];
+		}
+
+		/*
+		// from[x] is the length that first reached a total of x units, and used[x] how many Movies
+		// of that length the total holds. Totals are only ever reached once, so each walk back
+		// through from[] retraces a valid choice:
+		*/
+		for (units = 1; units <= capacity; ++units)
+		{
+			for (x = starts[units + 1] > starts[units] ? units : capacity + 1; x <= capacity; ++x)
+			{
+				if (from[x] == 0 && (x == units || from[x - units] != 0))
+				{
+					count = from[x - units] == units ? used[x - units] : 0;
+
+					if (count < starts[units + 1] - starts[units])
+					{
+						from[x] = units;
+						used[x] = count + 1;
+					}
+				}
+			}
+		}
+
+		for (best = capacity; best > 0 && from[best] == 0; --best)
+		{
+		}
+
+		for (count = 0, x = best; x > 0; x -= from[x])
+		{
+			++count;
+		}
+
+		*plan   = malloc(count * sizeof(Movie*) + 1);
+		scratch = malloc(count * sizeof(Movie*) + 1);
+		status  = *plan == NULL || scratch == NULL ? ENOMEM : 0;
+	}
+
+	if (status == 0)
+	{
+		for (count = 0, x = best; x > 0; x -= from[x])
+		{
+			(*plan)[count++] = candidates[starts[from[x]]++];
+		}
+
+		sortMovies(*plan, scratch, count, ByDuration);
+	}
+
+	if (status != 0)
+	{
+		free(*plan);
+		*plan = NULL;
+		count = -1;
+		errno = status;
+	}
+
+	free(starts);
+	free(used);
+	free(from);
+	free(candidates);
+	free(scratch);
+
+	return count;
+}
+
+/*
+// Plans the Movies of a given library that best fill what a given budget leaves of a given
+// watchlist's duration, see planDurationBudget, and moves them to the end of the watchlist.
+//
+// [in] library   - The library of Movies
+// [in] watchlist - The watchlist of Movies
+// [in] budget    - The total duration in hours the watchlist should fill
+// [in] filter    - The genres to choose from, indexed by genre id, or NULL for all genres
+//
+// Returns the count of Movies added, or -1 on error, when the Movies added before the error remain
+// in the watchlist.
+*/
+int fillWatchlist(MovieList* library, MovieList* watchlist, double budget, const bool* filter)
+{
+	int     status = 0;
+	Movie** plan   = NULL;
+	int     count  = planDurationBudget(library, budget - computeDuration(watchlist), filter, &plan);
+	int     i      = 0;
+
+	for (i = 0; status == 0 && i < count; ++i)
+	{
+		status = transferMovie(library, watchlist, plan[i], getCount(watchlist));
+
+		if (status == 0)
+		{
+			printMovie(plan[i]);
+		}
+	}
+
+	free(plan);
+
+	if (status != 0)
+	{
+		errno = status;
+		count = -1;
+	}
+
+	return count;
+}
+
+/*=========================================================================================================
+// Movie Watchlist
+//=======================================================================================================*/
+
+/*
+// Enum of all Watchlist menu options.
+*/
+typedef enum WatchlistMenuOption
+{
+	PrintWatchlist     = 1,
+	ShowDuration       = 2,
+	SearchWatchlist    = 3,
+	MoveMovieUp        = 4,
+	MoveMovieDown      = 5,
+	RemoveMovie        = 6,
+	SaveWatchlist      = 7,
+	LoadWatchlist      = 8,
+	GoToLibrary        = 9,
+	ShowStats          = 10,
+	SortWatchlist      = 11,
+	PlanWatchlist      = 12,
+	AddGenre           = 13,
+	AddPrefix          = 14,
+	RemoveGenre        = 15,
+	UniteWatchlist     = 16,
+	IntersectWatchlist = 17,
+	Quit               = 18
+} WatchlistMenuOption;
+
+/*
+// Computes the size and hash of the contents of a given file, which identify the snapshot a
+// journal applies to.
+//
+// [in]  fileName - The name of the file
+// [out] size     - The size of the file
+// [out] hash     - The hash of the file's contents
+//
+// Returns error status code.
+*/
+int hashSnapshot(const char* fileName, uint64_t* size, unsigned int* hash)
+{
+	int         status  = 0;
+	FileMapping mapping = {0};
+
+	status = mapFile(fileName, &mapping);
+
+	if (status == 0)
+	{
+		*size = (uint64_t)mapping.size;
+		*hash = hashBytes(mapping.data, mapping.size);
+
+		unmapFile(&mapping);
+	}
+
+	return status;
+}
+
+/*
+// Creates an empty journal of the changes made to a watchlist after a given file was written.
+//
+// [in]  fileName    - The name of the watchlist file
+// [in]  journalName - The name of the file to write the journal to
+// [in]  size        - The size of the watchlist file's contents, see hashSnapshot
+// [in]  hash        - The hash of the watchlist file's contents
+// [out] journal     - The journal, to be released with closeJournal
+//
+// Returns error status code.
+*/
+int createJournal(const char* fileName, const char* journalName, uint64_t size, unsigned int hash, Journal** journal)
+{
+	int      status = 0;
+	Journal* result = NULL;
+
+	if (status == 0)
+	{
+		result = calloc(1, sizeof(Journal));
+
+		if (result == NULL || (result->snapshotName = malloc(strlen(fileName) + 1)) == NULL)
+		{
+			status = ENOMEM;
+		}
+	}
+
+	if (status == 0)
+	{
+		strcpy(result->snapshotName, fileName);
+
+		result->file = fopen(journalName, "w");
+
+		if (result->file == NULL)
+		{
+			status = errno;
+		}
+	}
+
+	if (status == 0)
+	{
+		fprintf(result->file, "%s %d %llu %u\n", JOURNAL_MAGIC, JOURNAL_VERSION, (unsigned long long)size, hash);
+
+		status = syncFile(result->file);
+	}
+
+	if (status == 0)
+	{
+		*journal = result;
+	}
+	else
+	{
+		closeJournal(result);
+	}
+
+	return status;
+}
+
+/*
+// Starts a new, empty journal of the changes made to a given watchlist after it was written to or
+// read from a given file, replacing any journal the watchlist had.
+//
+// [in] list     - The watchlist of Movies
+// [in] fileName - The name of the watchlist file
+//
+// Returns error status code.
+*/
+int startJournal(MovieList* list, const char* fileName)
+{
+	int          status  = 0;
+	char*        name    = NULL;
+	char*        pending = NULL;
+	uint64_t     size    = 0;
+	unsigned int hash    = 0;
+
+	if (status == 0)
+	{
+		name    = getJournalName(fileName);
+		pending = getPendingJournalName(fileName);
+
+		if (name == NULL || pending == NULL)
+		{
+			status = ENOMEM;
+		}
+	}
+
+	if (status == 0)
+	{
+		status = hashSnapshot(fileName, &size, &hash);
+	}
+
+	closeJournal(list->journal);
+	list->journal = NULL;
+
+	if (status == 0)
+	{
+		status = createJournal(fileName, name, size, hash, &list->journal);
+	}
+
+	/*
+	// Any journal left pending by an interrupted save is superseded:
+	*/
+	if (status == 0)
+	{
+		remove(pending);
+	}
+
+	free(name);
+	free(pending);
+
+	return status;
+}
+
+/*
+// Reads one line of a journal record, without its newline.
+//
+// [in]  input    - The journal
+// [out] line     - The line
+// [in]  capacity - The capacity of the line
+//
+// Returns true if a complete line was read.
+*/
+bool readJournalLine(FILE* input, char* line, int capacity)
+{
+	bool   complete = false;
+	size_t length   = 0;
+
+	if (fgets(line, capacity, input) != NULL)
+	{
+		length   = strlen(line);
+		complete = length > 0 && line[length - 1] == '\n';
+
+		if (complete)
+		{
+			line[length - 1] = '\0';
+		}
+	}
+
+	return complete;
+}
+
+/*
+// Applies the journal of a given watchlist file to the watchlist just read from it. A journal
+// written against different file contents is stale and ignored, as is a torn final record.
+//
+// [in] list     - The watchlist of Movies read from the file, without a journal
+// [in] fileName - The name of the watchlist file
+//
+// Returns the count of records applied.
+*/
+int replayJournal(MovieList* list, const char* fileName)
+{
+	int                records                     = 0;
+	char*              name                        = NULL;
+	FILE*              input                       = NULL;
+	char               line[100]                   = {0};
+	char               title[MAX_TITLE_LENGTH + 2] = {0};
+	char               genre[100]                  = {0};
+	char               magic[5]                    = {0};
+	int                version                     = 0;
+	unsigned long long size                        = 0;
+	unsigned int       hash                        = 0;
+	uint64_t           actualSize                  = 0;
+	unsigned int       actualHash                  = 0;
+	int                position                    = 0;
+	double             duration                    = 0.0;
+	Movie*             movie                       = NULL;
+	bool               hashed                      = hashSnapshot(fileName, &actualSize, &actualHash) == 0;
+	bool               valid                       = false;
+	int                i                           = 0;
+
+	/*
+	// A save interrupted after its file was replaced leaves the matching journal pending:
+	*/
+	for (i = 0; hashed && !valid && i < 2; ++i)
+	{
+		name  = i == 0 ? getJournalName(fileName) : getPendingJournalName(fileName);
+		input = name != NULL ? fopen(name, "r") : NULL;
+
+		if (input != NULL && readJournalLine(input, line, sizeof(line)))
+		{
+			valid = sscanf(line, "%4s %d %llu %u", magic, &version, &size, &hash) == 4 && strcmp(magic, JOURNAL_MAGIC) == 0 &&
+			        version == JOURNAL_VERSION && size == actualSize && hash == actualHash;
+		}
+
+		if (input != NULL && !valid)
+		{
+			fclose(input);
+			input = NULL;
+		}
+
+		free(name);
+	}
+
+	while (valid && readJournalLine(input, line, sizeof(line)) && readJournalLine(input, title, sizeof(title)))
+	{
+		valid = false;
+
+		if (line[0] == 'I' && sscanf(line, "I %d %lf", &position, &duration) == 2 && readJournalLine(input, genre, sizeof(genre)))
+		{
+			movie = createMovieNode(title, genre, duration);
+			valid = movie != NULL && insertMovie(list, movie, position) == 0;
+
+			if (movie != NULL && !valid)
+			{
+				releaseMovie(&moviePool, movie);
+			}
+		}
+		else if (strcmp(line, "R") == 0 && (movie = searchByTitle(list, title)) != NULL)
+		{
+			valid = deleteMovie(list, movie) == 0;
+		}
+		else if (strcmp(line, "S") == 0 && (movie = searchByTitle(list, title)) != NULL)
+		{
+			valid = swapWithNextMovie(list, movie) == 0;
+		}
+		else if (strcmp(line, "O") == 0 && findMovieOrder(title) >= 0)
+		{
+			valid = sortMovieList(list, (MovieOrder)findMovieOrder(title)) == 0;
+		}
+
+		records += valid;
+	}
+
+	if (input != NULL)
+	{
+		STATS_ADD_FILE(bytesRead, input);
+		fclose(input);
+	}
+
+	return records;
+}
+
+/*
+// Formats the whole of a given linked list of Movies as the contents of a given file: text, or
+// binary for file names ending in BINARY_FILE_EXTENSION.
+//
+// [in]  list     - The linked list of Movies
+// [in]  fileName - The name of the file
+// [out] data     - The contents, to be freed by the caller
+// [out] size     - The size of the contents
+//
+// Returns error status code.
+*/
+int formatMovieWatchlistFile(MovieList* list, const char* fileName, char** data, size_t* size)
+{
+	int    status   = 0;
+	char*  grown    = NULL;
+	size_t capacity = 0;
+	int    length   = 0;
+	Movie* itr      = NULL;
+
+	*data = NULL;
+	*size = 0;
+
+	if (status == 0)
+	{
+		if (list == NULL || list->head == NULL || fileName == NULL)
+		{
+			status = EINVAL;
+		}
+	}
+
+	if (status == 0 && isBinaryFileName(fileName))
+	{
+		status = formatMovieListBinary(list, data, size);
+	}
+	else if (status == 0)
+	{
+		for (itr = list->head; status == 0 && itr != NULL; itr = getMovie(itr->next))
+		{
+			if (capacity - *size < MOVIE_TEXT_CAPACITY)
+			{
+				capacity = capacity == 0 ? 64 * 1024 : capacity * 2;
+				grown    = realloc(*data, capacity);
+
+				if (grown == NULL)
+				{
+					status = ENOMEM;
+					break;
+				}
+
+				*data = grown;
+			}
+
+			length = snprintf(*data + *size, capacity - *size, "%s\n%s\n%.2f%s", itr->title, getGenreName(itr->genreId), itr->duration,
+			                  itr->next != 0 ? "\n" : "");
+			*size += length;
+		}
+	}
+
+	if (status != 0)
+	{
+		free(*data);
+		*data = NULL;
+	}
+
+	return status;
+}
+
+/*
+// Writes the whole of a given linked list of Movies into a given text file, replacing its contents
+// atomically. File names ending in BINARY_FILE_EXTENSION are written in the binary format instead.
+//
+// [in] list     - The linked list of Movies
+// [in] fileName - The name of the file to write
+//
+// Returns error status code.
+*/
+int writeMovieWatchlistFile(MovieList* list, const char* fileName)
+{
+	int    status = 0;
+	char*  data   = NULL;
+	size_t size   = 0;
+
+	status = formatMovieWatchlistFile(list, fileName, &data, &size);
+
+	if (status == 0)
+	{
+		status = replaceFile(fileName, data, size);
+
+		STATS_ADD(bytesWritten, size);
+	}
+
+	free(data);
+
+	return status;
+}
+
+/*
+// Waits for the background write of a given watchlist's file, if any, see startBackgroundSave. If
+// the write failed the watchlist is left without a journal, so the next save writes it whole.
+//
+// [in] list - The watchlist of Movies
+//
+// Returns error status code of the write.
+*/
+int finishWatchlistSave(MovieList* list)
+{
+	int status = 0;
+
+	if (list->journal != NULL)
+	{
+		status = finishJournalSave(list->journal);
+
+		if (status != 0)
+		{
+			closeJournal(list->journal);
+			list->journal = NULL;
+		}
+	}
+
+	return status;
+}
+
+/*
+// Starts writing given contents of a given watchlist's file on a background thread, and a new
+// journal against those contents. Until the write is finished the old journal is kept up as well,
+// see Journal.
+//
+// [in] list     - The watchlist of Movies
+// [in] fileName - The name of the watchlist file
+// [in] data     - The contents, see formatMovieWatchlistFile; released by this function
+// [in] size     - The size of the contents
+//
+// Returns error status code.
+*/
+int startBackgroundSave(MovieList* list, const char* fileName, char* data, size_t size)
+{
+	int             status  = 0;
+	BackgroundSave* save    = NULL;
+	Journal*        journal = NULL;
+	char*           pending = NULL;
+
+	finishWatchlistSave(list);
+
+	if (status == 0)
+	{
+		save    = calloc(1, sizeof(BackgroundSave));
+		pending = getPendingJournalName(fileName);
+
+		if (save == NULL || pending == NULL || (save->fileName = malloc(strlen(fileName) + 1)) == NULL)
+		{
+			status = ENOMEM;
+		}
+	}
+
+	if (status == 0)
+	{
+		strcpy(save->fileName, fileName);
+		save->data = data;
+		save->size = size;
+		data       = NULL;
+
+		status = createJournal(fileName, pending, size, hashBytes(save->data, size), &journal);
+	}
+
+	if (status == 0)
+	{
+		status = startThread(&save->thread, runBackgroundSave, save);
+
+		if (status != 0)
+		{
+			closeJournal(journal);
+			remove(pending);
+		}
+	}
+
+	if (status == 0)
+	{
+		STATS_ADD(bytesWritten, size);
+
+		journal->save = save;
+		save          = NULL;
+
+		if (list->journal != NULL && strcmp(list->journal->snapshotName, fileName) == 0)
+		{
+			journal->previous   = list->journal->file;
+			list->journal->file = NULL;
+		}
+
+		closeJournal(list->journal);
+		list->journal = journal;
+	}
+
+	if (save != NULL)
+	{
+		free(save->fileName);
+		free(save->data);
+		free(save);
+	}
+
+	free(data);
+	free(pending);
+
+	return status;
+}
+
+/*
+// Saves a given watchlist into a given file. A watchlist already journaled against that file only
+// needs its journal synced, until the journal outgrows the watchlist and is compacted by writing
+// the whole watchlist and starting a new journal. See Journal.
+//
+// The whole watchlist is formatted before this returns, but written on a background thread; see
+// finishWatchlistSave to wait for the write and learn whether it succeeded.
+//
+// [in] list     - The watchlist of Movies
+// [in] fileName - The name of the file to save to
+//
+// Returns error status code.
+*/
+int saveMovieWatchlistFile(MovieList* list, const char* fileName)
+{
+	int      status  = 0;
+	Journal* journal = NULL;
+	char*    data    = NULL;
+	size_t   size    = 0;
+
+	if (status == 0)
+	{
+		if (list == NULL || fileName == NULL)
+		{
+			status = EINVAL;
+		}
+	}
+
+	if (status == 0)
+	{
+		/*
+		// A failed earlier write leaves no journal, so this save writes the watchlist whole:
+		*/
+		finishWatchlistSave(list);
+
+		journal = list->journal;
+
+		if (journal != NULL && strcmp(journal->snapshotName, fileName) == 0 && !ferror(journal->file) &&
+		    (list->head == NULL || journal->records < JOURNAL_COMPACT_MIN_RECORDS || journal->records <= list->count))
+		{
+			status = syncFile(journal->file);
+		}
+		else
+		{
+			status = formatMovieWatchlistFile(list, fileName, &data, &size);
+
+			if (status == 0)
+			{
+				status = startBackgroundSave(list, fileName, data, size);
+			}
+		}
+	}
+
+	return status;
+}
+
+/*
+// Prompts for the name of a text file and stores the given linked list of Movies into that text file.
+// File names ending in BINARY_FILE_EXTENSION are written in the binary format instead.
+//
+// [in] list - The linked list of Movies
+//
+// Returns error status code.
+*/
+int saveMovieWatchlist(MovieList* list)
+{
+	int  status        = 0;
+	char fileName[200] = {0};
+
+	if (status == 0)
+	{
+		if (list == NULL || list->head == NULL)
+		{
+			status = EINVAL;
+		}
+	}
+
+	if (status == 0)
+	{
+		promptFor(fileName, sizeof(fileName), "Enter the name of the file to save watchlist to: ");
+		printf("\n");
+
+		status = saveMovieWatchlistFile(list, fileName);
+	}
+
+	return status;
+}
+
+/*
+// Reads a given watchlist file into a linked list of Movies of its own and brings it up to date
+// with the file's journal, see replayJournal. File names ending in BINARY_FILE_EXTENSION are read
+// in the binary format. Records of either format are checked and duplicate titles dropped as for
+// library files, see indexMovieList, and any dropped are reported on stderr.
+//
+// [in]  fileName - The name of the file to read
+// [out] loaded   - The empty linked list of Movies to fill; on error the caller deletes it
+// [out] replayed - The count of journal records replayed
+//
+// Returns error status code.
+*/
+int readMovieWatchlistFile(const char* fileName, MovieList* loaded, int* replayed)
+{
+	int          status = 0;
+	FILE*        input  = NULL;
+	IngestReport report = {0};
+
+	*replayed = 0;
+
+	if (status == 0)
+	{
+		if (fileName == NULL)
+		{
+			status = EINVAL;
+		}
+		else if (isBinaryFileName(fileName))
+		{
+			status = loadMovieListBinary(fileName, &moviePool, loaded, false, &report);
+		}
+		else
+		{
+			input = fopen(fileName, "rb");
+
+			if (input == NULL)
+			{
+				status = errno;
+			}
+			else
+			{
+				status = readMovieRecords(input, &moviePool, loaded, &report);
+			}
+		}
+	}
+
+	/*
+	// Either format may repeat a title, which would otherwise reach the watchlist twice:
+	*/
+	if (status == 0)
+	{
+		status = indexMovieList(loaded, &report);
+	}
+
+	if (status == 0)
+	{
+		printIngestReport(&report, fileName, stderr);
+	}
+
+	clearIngestReport(&report);
+
+	if (status == 0)
+	{
+		*replayed = replayJournal(loaded, fileName);
+	}
+
+	if (input != NULL)
+	{
+		STATS_ADD_FILE(bytesRead, input);
+		fclose(input);
+	}
+
+	return status;
+}
+
+//
+// Reads a given watchlist file, see readMovieWatchlistFile, in place of the watchlist. Movies found
+// in the watchlist are removed from the library.
+//
+// [in]  library   - The library of Movies
+// [out] watchlist - The watchlist of Movies, replaced on success
+// [in]  fileName  - The name of the file to read
+//
+// Returns error status code.
+//
+int loadMovieWatchlistFile(MovieList* library, MovieList* watchlist, const char* fileName)
+{
+	int       status   = 0;
+	MovieList loaded   = {0};
+	Movie*    itr      = NULL;
+	Movie*    match    = NULL;
+	int       replayed = 0;
+
+	/*
+	// The file may still be being written by the last save:
+	*/
+	finishWatchlistSave(watchlist);
+
+	status = readMovieWatchlistFile(fileName, &loaded, &replayed);
+
+	if (status == 0)
+	{
+		/*
+		// Files do not record which library file a Movie came from, so take it from the library or
+		// the watchlist being replaced. A lazy library decodes the titles as they are looked up, so
+		// the join below sees them:
+		*/
+		for (itr = loaded.head; itr != NULL; itr = getMovie(itr->next))
+		{
+			match        = findLibraryMovie(library, itr->title);
+			match        = match != NULL ? match : searchByTitle(watchlist, itr->title);
+			itr->catalog = match != NULL ? match->catalog : 0;
+		}
+
+		deleteMatchingMovies(library, &loaded);
+
+		deleteList(watchlist);
+		*watchlist = loaded;
+
+		/*
+		// Fold the replayed changes into the file and journal from here on. The watchlist is loaded
+		// either way, so a failure here only means changes wait for the next save:
+		*/
+		if (watchlist->head != NULL && (replayed == 0 || writeMovieWatchlistFile(watchlist, fileName) == 0))
+		{
+			startJournal(watchlist, fileName);
+		}
+	}
+	else
+	{
+		deleteList(&loaded);
+	}
+
+	return status;
+}
+
+//
+// Prompts for the name of a text file and stores the contents as a linked list of Movies. Movies
+// found in the watchlist are removed from the library. File names ending in BINARY_FILE_EXTENSION
+// are read in the binary format instead.
+//
+// [in]  library   - The library of Movies
+// [out] watchlist - The watchlist of Movies, replaced on success
+//
+// Returns error status code.
+//
+int loadMovieWatchlist(MovieList* library, MovieList* watchlist)
+{
+	char fileName[200] = {0};
+
+	promptFor(fileName, sizeof(fileName), "Enter the name of the file to read the watchlist from: ");
+	printf("\n");
+
+	return loadMovieWatchlistFile(library, watchlist, fileName);
+}
+
+/*
+// Moves the Movies of given genres from one linked list of Movies to the end of another as one set
+// operation, see transferMovies, genre by genre. The genre buckets hold the Movies of each genre,
+// so no other Movie is looked at.
+//
+// [in] source      - The linked list of Movies to move from
+// [in] destination - The linked list of Movies to move to
+// [in] filter      - The genres to move, indexed by genre id, see parseGenreFilter
+//
+// Returns the count of Movies moved, or -1 on error. A lazy library holds only the Movies looked
+// up so far, so moving from one fails with ENOTSUP.
+*/
+int moveGenreMovies(MovieList* source, MovieList* destination, const bool* filter)
+{
+	int     status = 0;
+	Movie** movies = NULL;
+	int     count  = 0;
+	Movie*  itr    = NULL;
+	int     id     = 0;
+
+	if (source->catalog != NULL)
+	{
+		status = ENOTSUP;
+	}
+	else if (filter == NULL)
+	{
+		status = EINVAL;
+	}
+
+	if (status == 0)
+	{
+		for (id = 0; id < source->genreBucketCount; ++id)
+		{
+			count += filter[id] ? source->genreBuckets[id].count : 0;
+		}
+
+		movies = malloc(count * sizeof(Movie*) + 1);
+		status = movies == NULL ? ENOMEM : 0;
+	}
+
+	if (status == 0)
+	{
+		for (id = 0, count = 0; id < source->genreBucketCount; ++id)
+		{
+			for (itr = filter[id] ? source->genreBuckets[id].head : NULL; itr != NULL; itr = getMovie(itr->genreNext))
+			{
+				movies[count++] = itr;
+			}
+		}
+
+		status = transferMovies(source, destination, movies, count);
+	}
+
+	free(movies);
+
+	if (status != 0)
+	{
+		errno = status;
+		count = -1;
+	}
+
+	return count;
+}
+
+/*
+// Moves every library Movie whose title starts with a given prefix, ignoring case, to the end of
+// the watchlist in title order, as one set operation, see transferMovies.
+//
+// [in] library   - The library of Movies
+// [in] watchlist - The watchlist of Movies
+// [in] prefix    - The title prefix
+//
+// Returns the count of Movies moved, or -1 on error. Fails with ENOTSUP for a lazy library, see
+// moveGenreMovies.
+*/
+int addPrefixMovies(MovieList* library, MovieList* watchlist, const char* prefix)
+{
+	int     status = 0;
+	Movie** movies = NULL;
+	int     count  = 0;
+
+	if (library->catalog != NULL)
+	{
+		status = ENOTSUP;
+	}
+	else if ((count = searchByPrefix(library, prefix, &movies)) < 0)
+	{
+		status = errno;
+	}
+	else
+	{
+		status = transferMovies(library, watchlist, movies, count);
+	}
+
+	free(movies);
+
+	if (status != 0)
+	{
+		errno = status;
+		count = -1;
+	}
+
+	return count;
+}
+
+/*
+// Adds the Movies of a given saved watchlist file that the watchlist lacks, taking them from the
+// library, in one pass over the file that probes the watchlist's and the library's title indexes
+// and one set operation, see transferMovies. The file is read as loadMovieWatchlistFile reads it,
+// and its titles that are in neither list are counted on stderr.
+//
+// [in] library   - The library of Movies
+// [in] watchlist - The watchlist of Movies
+// [in] fileName  - The name of the saved watchlist file
+//
+// Returns the count of Movies added, or -1 on error.
+*/
+int uniteWatchlistFile(MovieList* library, MovieList* watchlist, const char* fileName)
+{
+	int       status   = 0;
+	MovieList loaded   = {0};
+	Movie**   movies   = NULL;
+	Movie*    movie    = NULL;
+	Movie*    itr      = NULL;
+	int       count    = 0;
+	int       missing  = 0;
+	int       replayed = 0;
+
+	/*
+	// The file may still be being written by the last save:
+	*/
+	finishWatchlistSave(watchlist);
+
+	status = readMovieWatchlistFile(fileName, &loaded, &replayed);
+
+	if (status == 0)
+	{
+		movies = malloc(loaded.count * sizeof(Movie*) + 1);
+		status = movies == NULL ? ENOMEM : 0;
+	}
+
+	if (status == 0)
+	{
+		for (itr = loaded.head; itr != NULL; itr = getMovie(itr->next))
+		{
+			if (searchByTitle(watchlist, itr->title) == NULL)
+			{
+				movie = findLibraryMovie(library, itr->title);
+
+				if (movie != NULL)
+				{
+					movies[count++] = movie;
+				}
+				else
+				{
+					++missing;
+				}
+			}
+		}
+
+		if (missing > 0)
+		{
+			fprintf(stderr, "%s: %d movies are in neither the watchlist nor the library.\n", fileName, missing);
+		}
+
+		status = transferMovies(library, watchlist, movies, count);
+	}
+
+	deleteList(&loaded);
+	free(movies);
+
+	if (status != 0)
+	{
+		errno = status;
+		count = -1;
+	}
+
+	return count;
+}
+
+/*
+// Returns the watchlist Movies whose titles are not in a given saved watchlist file to the end of
+// the library, in one pass over the watchlist that probes the file's title index and one set
+// operation, see transferMovies. The file is read as loadMovieWatchlistFile reads it.
+//
+// [in] library   - The library of Movies
+// [in] watchlist - The watchlist of Movies
+// [in] fileName  - The name of the saved watchlist file
+//
+// Returns the count of Movies returned to the library, or -1 on error.
+*/
+int intersectWatchlistFile(MovieList* library, MovieList* watchlist, const char* fileName)
+{
+	int       status   = 0;
+	MovieList loaded   = {0};
+	Movie**   movies   = NULL;
+	Movie*    itr      = NULL;
+	int       count    = 0;
+	int       replayed = 0;
+
+	finishWatchlistSave(watchlist);
+
+	status = readMovieWatchlistFile(fileName, &loaded, &replayed);
+
+	if (status == 0)
+	{
+		movies = malloc(watchlist->count * sizeof(Movie*) + 1);
+		status = movies == NULL ? ENOMEM : 0;
+	}
+
+	if (status == 0)
+	{
+		for (itr = watchlist->head; itr != NULL; itr = getMovie(itr->next))
+		{
+			if (searchByTitle(&loaded, itr->title) == NULL)
+			{
+				movies[count++] = itr;
+			}
+		}
+
+		status = transferMovies(watchlist, library, movies, count);
+	}
+
+	deleteList(&loaded);
+	free(movies);
+
+	if (status != 0)
+	{
+		errno = status;
+		count = -1;
+	}
+
+	return count;
+}
+
+/*
+// Returns the name of a given Watchlist menu option, as reported by the stats.
+//
+// [in] option - The Watchlist menu option
+*/
+const char* getWatchlistOptionName(WatchlistMenuOption option)
+{
+	static const char* names[] =
+	{
+		"Unknown", "Print watchlist", "Show duration", "Search by title", "Move a movie up", "Move a movie down",
+		"Remove a movie", "Save watchlist", "Load watchlist", "Go to movie library", "Show stats",
+		"Sort watchlist", "Plan by time budget", "Add movies by genre", "Add movies by title prefix",
+		"Remove movies by genre", "Add movies of a saved watchlist",
+		"Keep only movies of a saved watchlist", "Quit"
+	};
+
+	return (int)option >= 0 && (int)option < (int)_countof(names) ? names[option] : names[0];
+}
+
+/*
+// Prints the Watchlist menu.
+*/
+void printWatchlistMenu()
+{
+	printf("*** Watchlist Menu ***\n");
+	printf(" 1) Print watchlist\n");
+	printf(" 2) Show duration\n");
+	printf(" 3) Search by title\n");
+	printf(" 4) Move a movie up\n");
+	printf(" 5) Move a movie down\n");
+	printf(" 6) Remove a movie\n");
+	printf(" 7) Save watchlist\n");
+	printf(" 8) Load watchlist\n");
+	printf(" 9) Go to movie library\n");
+	printf("10) Show stats\n");
+	printf("11) Sort watchlist\n");
+	printf("12) Plan by time budget\n");
+	printf("13) Add movies by genre\n");
+	printf("14) Add movies by title prefix\n");
+	printf("15) Remove movies by genre\n");
+	printf("16) Add movies of a saved watchlist\n");
+	printf("17) Keep only movies of a saved watchlist\n");
+	printf("18) Quit\n");
+	printf("\n");
+}
+
+/*
+// Prompts for and returns a Watchlist menu option choice.
+*/
+WatchlistMenuOption getWatchlistMenuOption()
+{
+	WatchlistMenuOption option = 0;
+
+	printWatchlistMenu();
+
+	option = promptForInt(1, 18, "Enter a menu choice: ");
+	printf("\n");
+
+	return option;
+}
+
+//
+// Handles a single Watchlist menu option.
+//
+// [in] option    - The library menu option
+// [in] library   - The library of Movies
+// [in] watchlist - The watchlist of Movies
+//
+void handleWatchlistMenuOption(WatchlistMenuOption option, MovieList* library, MovieList* watchlist)
+{
+	char   title[MAX_TITLE_LENGTH + 1] = {0};
+	Movie* temp                        = NULL;
+	double budget                      = 0.0;
+	bool*  filter                      = NULL;
+	int    count                       = 0;
+	STATS_TIMER(start);
+
+	switch (option)
+	{
+		case PrintWatchlist:
+		{
+			printMoviePages(watchlist);
+			break;
+		}
+
+		case ShowDuration:
+		{
+			printf("Duration is %.2f hours.\n", computeDuration(watchlist));
+			printf("\n");
+			break;
+		}
+
+		case SearchWatchlist:
+		{
+			promptFor(title, sizeof(title), "Enter a title to search: ");
+			printf("\n");
+
+			if (searchByTitle(watchlist, title) != NULL)
+			{
+				printf("%s found in the watchlist.\n", title);
+				printf("\n");
+			}
+			else
+			{
+				printf("%s not found in the watchlist.\n", title);
+				printf("\n");
+			}
+			break;
+		}
+
+		case MoveMovieUp:
+		{
+			promptFor(title, sizeof(title), "Enter the title of the movie to move up: ");
+			printf("\n");
+			temp = searchByTitle(watchlist, title);
+
+			if (temp != NULL)
+			{
+				if (temp != watchlist->head)
+				{
+					swapWithNextMovie(watchlist, getMovie(temp->prev));
+				}
+			}
+			else
+			{
+				printf("%s not found in the watchlist. Please search for movies before attempting to move.\n", title);
+				printf("\n");
+			}
+			break;
+		}
+
+		case MoveMovieDown:
+		{
+			promptFor(title, sizeof(title), "Enter the title of the movie to move down: ");
+			printf("\n");
+			temp = searchByTitle(watchlist, title);
+
+			if (temp != NULL)
+			{
+				if (temp->next != 0)
+				{
+					swapWithNextMovie(watchlist, temp);
+				}
+			}
+			else
+			{
+				printf("%s not found in the watchlist. Please search for movies before attempting to move.\n", title);
+				printf("\n");
+			}
+			break;
+		}
+
+		case RemoveMovie:
+		{
+			promptFor(title, sizeof(title), "Enter the title of the movie to remove: ");
+			printf("\n");
+			temp = searchByTitle(watchlist, title);
+
+			if (temp != NULL)
+			{
+				transferMovie(watchlist, library, temp, getCount(library));
+			}
+			else
+			{
+				printf("%s not found in the watchlist. Please search for movies before attempting to remove.\n", title);
+				printf("\n");
+			}
+
+			break;
+		}
+
+		case SaveWatchlist:
+		{
+			saveMovieWatchlist(watchlist);
+			break;
+		}
+
+		case LoadWatchlist:
+		{
+			loadMovieWatchlist(library, watchlist);
+			break;
+		}
+
+		case GoToLibrary:
+		{
+			pageBreak();
+
+			handleLibrary(library, watchlist);
+			break;
+		}
+
+		case ShowStats:
+		{
+			printStats();
+			break;
+		}
+
+		case SortWatchlist:
+		{
+			if (sortMovieList(watchlist, promptForMovieOrder()) != 0)
+			{
+				perror("Failed to sort the watchlist");
+				printf("\n");
+			}
+			break;
+		}
+
+		case PlanWatchlist:
+		{
+			budget = promptForDouble(0.0, PLAN_MAX_HOURS, "Enter the hours the watchlist should fill: ");
+			promptFor(title, sizeof(title), "Enter genres separated by commas, or nothing for any genre: ");
+			printf("\n");
+
+			if (parseGenreFilter(title, &filter) != 0)
+			{
+				printf("%s names a genre that is not in the library.\n", title);
+				printf("\n");
+			}
+			else if ((count = fillWatchlist(library, watchlist, budget, filter)) < 0)
+			{
+				perror("Failed to plan the watchlist");
+				printf("\n");
+			}
+			else
+			{
+				printf("%sAdded %d movies, the watchlist is now %.2f hours.\n", count > 0 ? "\n" : "", count, computeDuration(watchlist));
+				printf("\n");
+			}
+
+			free(filter);
+			break;
+		}
+
+		case AddGenre:
+		case RemoveGenre:
+		{
+			promptFor(title, sizeof(title), "Enter genres separated by commas: ");
+			printf("\n");
+
+			if (parseGenreFilter(title, &filter) != 0 || filter == NULL)
+			{
+				printf("%s does not name genres in the library.\n", title);
+			}
+			else if ((count = option == AddGenre ? moveGenreMovies(library, watchlist, filter) : moveGenreMovies(watchlist, library, filter)) < 0)
+			{
+				perror("Failed to move the movies");
+			}
+			else
+			{
+				printf("%s %d movies, the watchlist is now %.2f hours.\n", option == AddGenre ? "Added" : "Removed", count, computeDuration(watchlist));
+			}
+
+			printf("\n");
+			free(filter);
+			break;
+		}
+
+		case AddPrefix:
+		{
+			promptFor(title, sizeof(title), "Enter the title prefix of the movies to add: ");
+			printf("\n");
+
+			if ((count = addPrefixMovies(library, watchlist, title)) < 0)
+			{
+				perror("Failed to add the movies");
+			}
+			else
+			{
+				printf("Added %d movies, the watchlist is now %.2f hours.\n", count, computeDuration(watchlist));
+			}
+
+			printf("\n");
+			break;
+		}
+
+		case UniteWatchlist:
+		case IntersectWatchlist:
+		{
+			promptFor(title, sizeof(title), "Enter the name of the saved watchlist file: ");
+			printf("\n");
+
+			count = option == UniteWatchlist ? uniteWatchlistFile(library, watchlist, title) : intersectWatchlistFile(library, watchlist, title);
+
+			if (count < 0)
+			{
+				perror(title);
+			}
+			else
+			{
+				printf("%s %d movies, the watchlist is now %.2f hours.\n", option == UniteWatchlist ? "Added" : "Removed", count, computeDuration(watchlist));
+			}
+
+			printf("\n");
+			break;
+		}
+
+		default:
+		{
+			fprintf(stderr, "Unhandled watchlist option.\n");
+		}
+	}
+
+	STATS_COMMAND(option, getWatchlistOptionName(option), start);
+}
+
+/*
+// Handles Watchlist menu selection and operations.
+//
+// [in] library   - The library of Movies
+// [in] watchlist - The watchlist of Movies
+*/
+void handleWatchlist(MovieList* library, MovieList* watchlist)
+{
+	WatchlistMenuOption option = 0;
+
+	while (true)
+	{
+		option = getWatchlistMenuOption();
+
+		if (option == Quit)
+		{
+			break;
+		}
+
+		handleWatchlistMenuOption(option, library, watchlist);
+		trimLibraryCache(library);
+
+		pageBreak();
+	}
+}
+
+/*=========================================================================================================
+// Batch Mode
+//=======================================================================================================*/
+
+#define BATCH_OUTPUT_BUFFER_SIZE (64 * 1024)
+#define BATCH_MAX_LINE_LENGTH    (MAX_TITLE_LENGTH + 32)  /* the longest command and position then a title, before "\r\n" */
+
+/*
+// A library Movie waiting to be appended to the watchlist, see flushBatchAdds.
+*/
+typedef struct BatchAdd
+{
+	Movie* movie;
+	int    line;
+} BatchAdd;
+
+/*
+// Appends a run of pending library Movies to the watchlist, growing its title index once for the
+// whole run.
+//
+// [in]     library   - The library of Movies
+// [in]     watchlist - The watchlist of Movies
+// [in,out] adds      - The pending Movies, emptied
+// [in,out] addCount  - The count of pending Movies, reset to 0
+//
+// Returns error status code of the first failed add.
+*/
+int flushBatchAdds(MovieList* library, MovieList* watchlist, BatchAdd* adds, int* addCount)
+{
+	int status = 0;
+	int result = 0;
+	int i      = 0;
+
+	/*
+	// Growing up front only saves rehashing; each add still grows the table itself if this fails:
+	*/
+	if (*addCount > 0)
+	{
+		reserveTitleIndex(&watchlist->titleIndex, *addCount);
+	}
+
+	for (i = 0; i < *addCount; ++i)
+	{
+		/*
+		// A title added twice in one run is no longer in the library the second time:
+		*/
+		result = transferMovie(library, watchlist, adds[i].movie, getCount(watchlist));
 
-		if (remainder == buffer || *remainder != '\0' || integer < minValue || integer > maxValue)
-		{
-			printf("\n");
-			printf("An integer between %d and %d was expected.\n", minValue, maxValue);
-			printf("\n");
-		}
-		else
+		if (result != 0)
 		{
-			break;
+			fprintf(stderr, "Line %d: %s not found in the library.\n", adds[i].line, adds[i].movie->title);
+			status = status == 0 ? result : status;
 		}
 	}
 
-	return integer;
+	*addCount = 0;
+
+	return status;
 }
 
 /*
-// Determines the count of Movies in a given linked list.
+// Splits a given command line in place into its command word and the argument that runs to the
+// end of the line.
 //
-// [in] list - The linked list of Movies
+// [in]  line     - The command line
+// [out] argument - The argument, empty if there is none
 //
-// Returns the count of Movies.
+// Returns the command, empty if the line is blank.
 */
-int getCount(Movie* list)
+char* splitCommand(char* line, char** argument)
 {
-	int count = 0;
+	char* command = NULL;
 
-	if (list != NULL)
-	{
-		++count;
+	line[strcspn(line, "\r\n")] = '\0';
 
-		while (list->next != NULL)
-		{
-			++count;
-			list = list->next;
-		}
+	command   = line + strspn(line, " \t");
+	*argument = command + strcspn(command, " \t");
+
+	if (**argument != '\0')
+	{
+		*(*argument)++ = '\0';
+		*argument     += strspn(*argument, " \t");
 	}
 
-	return count;
+	return command;
 }
 
 /*
-// Inserts a given Movie into a given linked list at a given position (zero-based).
+// Applies a given stream of watchlist commands, one per line, without prompting or printing menus.
+// Titles run to the end of the line, and lines starting with '#' are ignored:
 //
-// [in] list     	- The linked list of Movies
-// [in] insertMovie - The Movie to insert
-// [in] position    - The position in the linked list at which to insert
+//   add <title>                append a library Movie to the watchlist
+//   insert <position> <title>  insert a library Movie at a position (one-based) in the watchlist
+//   remove <title>             move a watchlist Movie back to the library
+//   up <title>                 move a watchlist Movie up
+//   down <title>               move a watchlist Movie down
+//   save <file>                save the watchlist
+//   load <file>                load the watchlist
+//   print                      print the watchlist
+//   duration                   print the duration of the watchlist
+//   sort <order>               sort the watchlist by title, duration or genre
+//   longest <count>            print the longest library Movies, longest first
+//   between <low> <high>       print the library Movies within a duration range in hours
+//   plan <hours> [<genres>]    fill the watchlist up to a duration from the library, optionally
+//                              only from given comma-separated genres
+//   addgenre <genres>          append every library Movie of given comma-separated genres
+//   addprefix <prefix>         append every library Movie whose title starts with a prefix
+//   removegenre <genres>       move every watchlist Movie of given genres back to the library
+//   union <file>               append the library Movies of a saved watchlist the watchlist lacks
+//   intersect <file>           move the watchlist Movies a saved watchlist lacks to the library
+//   stats                      print the counters and command latencies, see Stats
 //
-// Returns error status code.
+// Consecutive adds are applied together. Failed commands are reported on stderr and skipped, as
+// are lines longer than BATCH_MAX_LINE_LENGTH, none of which is run.
+//
+// [in] input     - The command stream
+// [in] library   - The library of Movies
+// [in] watchlist - The watchlist of Movies
+//
+// Returns error status code of the first failed command.
 */
-int insertMovie(Movie** list, Movie* insertMovie, int position)
+int runBatch(FILE* input, MovieList* library, MovieList* watchlist)
 {
-	int    status = 0;
-	Movie* prev   = NULL;
-	Movie* itr    = NULL;
-	int    count  = 0;
-
-	if (status == 0)
+	int         status                          = 0;
+	int         result                          = 0;
+	char        line[BATCH_MAX_LINE_LENGTH + 3] = {0};
+	int         lineNumber                      = 0;
+	char*       command                         = NULL;
+	char*       argument                        = NULL;
+	char*       remainder                       = NULL;
+	BatchAdd*   adds                            = NULL;
+	BatchAdd*   grown                           = NULL;
+	int         addCount                        = 0;
+	int         addCapacity                     = 0;
+	int         position                        = 0;
+	Movie*      movie                           = NULL;
+	char*       end                             = NULL;
+	SortedView* view                            = NULL;
+	bool*       filter                          = NULL;
+	Movie**     matches                         = NULL;
+	int         matchCount                      = 0;
+	double      low                             = 0.0;
+	double      high                            = 0.0;
+	int         i                               = 0;
+	int         c                               = 0;
+
+	/*
+	// Batches only search by prefix in addprefix, so rather than updating the library's search
+	// index on every returned Movie, drop it and let addprefix or a later search rebuild it:
+	*/
+	clearTitleSearchIndex(library->searchIndex);
+	library->searchIndex = NULL;
+
+	while (fgets(line, sizeof(line), input) != NULL)
 	{
-		if (list == NULL || insertMovie == NULL)
+		++lineNumber;
+		result = 0;
+
+		/*
+		// Drop the rest of a line too long for the buffer, so its tail is not taken for a command:
+		*/
+		if (strchr(line, '\n') == NULL && !feof(input))
 		{
-			status = EINVAL;
+			for (i = 0; (c = getc(input)) != EOF && c != '\n'; ++i)
+			{
+			}
+
+			if (i > 0)
+			{
+				fprintf(stderr, "Line %d: Line too long.\n", lineNumber);
+				status = status == 0 ? E2BIG : status;
+				continue;
+			}
 		}
-	}
 
-	if (status == 0)
-	{
-		itr = *list;
+		command = splitCommand(line, &argument);
+
+		if (*command == '\0' || *command == '#')
+		{
+			continue;
+		}
 
-		while (true)
+		if (strcmp(command, "add") == 0)
 		{
-			if (count == position)
+			movie = findLibraryMovie(library, argument);
+
+			if (movie != NULL && addCount == addCapacity)
 			{
-				if (prev != NULL)
+				grown = realloc(adds, (addCapacity + 256) * sizeof(BatchAdd));
+
+				if (grown == NULL)
 				{
-					prev->next = insertMovie;
+					movie = NULL;
 				}
-
-				insertMovie->next = itr;
-
-				if (position == 0)
+				else
 				{
-					*list = insertMovie;
+					adds         = grown;
+					addCapacity += 256;
 				}
+			}
 
-				break;
+			if (movie != NULL)
+			{
+				adds[addCount].movie = movie;
+				adds[addCount].line  = lineNumber;
+				++addCount;
+				continue;
 			}
-			else if (itr->next == NULL)
+		}
+
+		/*
+		// Anything other than a queued add applies the pending run first to keep commands in order:
+		*/
+		result = flushBatchAdds(library, watchlist, adds, &addCount);
+		status = status == 0 ? result : status;
+		result = 0;
+
+		if (strcmp(command, "add") == 0)
+		{
+			fprintf(stderr, "Line %d: %s not found in the library.\n", lineNumber, argument);
+			result = ENOENT;
+		}
+		else if (strcmp(command, "insert") == 0)
+		{
+			position = strtol(argument, &remainder, 10);
+			movie    = findLibraryMovie(library, remainder + strspn(remainder, " \t"));
+
+			if (remainder == argument || movie == NULL)
 			{
-				status = ERANGE;
-				break;
+				fprintf(stderr, "Line %d: Expected a position and a library title.\n", lineNumber);
+				result = EINVAL;
 			}
-			else
+			else if ((result = transferMovie(library, watchlist, movie, position - 1)) != 0)
 			{
-				prev = itr;
-				itr  = itr->next;
-				++count;
+				fprintf(stderr, "Line %d: A position from 1 to %d was expected.\n", lineNumber, getCount(watchlist) + 1);
 			}
 		}
-	}
+		else if (strcmp(command, "remove") == 0 || strcmp(command, "up") == 0 || strcmp(command, "down") == 0)
+		{
+			movie = searchByTitle(watchlist, argument);
 
-	return status;
-}
+			if (movie == NULL)
+			{
+				fprintf(stderr, "Line %d: %s not found in the watchlist.\n", lineNumber, argument);
+				result = ENOENT;
+			}
+			else if (command[0] == 'r')
+			{
+				result = transferMovie(watchlist, library, movie, getCount(library));
+			}
+			else if (command[0] == 'u' && movie->prev != 0)
+			{
+				result = swapWithNextMovie(watchlist, getMovie(movie->prev));
+			}
+			else if (command[0] == 'd' && movie->next != 0)
+			{
+				result = swapWithNextMovie(watchlist, movie);
+			}
+		}
+		else if (strcmp(command, "save") == 0 || strcmp(command, "load") == 0)
+		{
+			result = command[0] == 's' ? saveMovieWatchlistFile(watchlist, argument) : loadMovieWatchlistFile(library, watchlist, argument);
 
-/*
-// Appends a given Movie to the end of a given linked.
-//
-// [in] list     	- The linked list of Movies
-// [in] appendMovie - The Movie to append
-//
-// Returns error status code.
-*/
-int appendMovie(Movie** list, Movie* appendMovie)
-{
-	int    status = 0;
-	Movie* head   = NULL;
+			/*
+			// Wait for the write, so each line reports its own failure:
+			*/
+			if (result == 0 && command[0] == 's')
+			{
+				result = finishWatchlistSave(watchlist);
+			}
 
-	if (status == 0)
-	{
-		if (list == NULL || appendMovie == NULL)
+			if (result != 0)
+			{
+				fprintf(stderr, "Line %d: Failed to %s %s: %s\n", lineNumber, command, argument, strerror(result));
+			}
+		}
+		else if (strcmp(command, "print") == 0)
 		{
-			status = EINVAL;
+			printMovieList(watchlist);
 		}
-	}
+		else if (strcmp(command, "duration") == 0)
+		{
+			printf("Duration is %.2f hours.\n", computeDuration(watchlist));
+		}
+		else if (strcmp(command, "sort") == 0)
+		{
+			if (findMovieOrder(argument) < 0)
+			{
+				fprintf(stderr, "Line %d: Expected title, duration or genre.\n", lineNumber);
+				result = EINVAL;
+			}
+			else
+			{
+				result = sortMovieList(watchlist, (MovieOrder)findMovieOrder(argument));
+			}
+		}
+		else if (strcmp(command, "longest") == 0)
+		{
+			position = strtol(argument, &remainder, 10);
 
-	if (status == 0)
-	{
-		head = *list;
+			if (remainder == argument || position < 0)
+			{
+				fprintf(stderr, "Line %d: Expected a count.\n", lineNumber);
+				result = EINVAL;
+			}
+			else if ((view = getSortedView(library, ByDuration)) == NULL)
+			{
+				result = errno;
+			}
+			else
+			{
+				for (i = view->count - 1; i >= 0 && i >= view->count - position; --i)
+				{
+					printMovie(view->movies[i]);
+				}
+			}
+		}
+		else if (strcmp(command, "between") == 0)
+		{
+			low  = strtod(argument, &remainder);
+			high = strtod(remainder, &end);
 
-		if (head == NULL)
+			if (remainder == argument || end == remainder)
+			{
+				fprintf(stderr, "Line %d: Expected a shortest and a longest duration.\n", lineNumber);
+				result = EINVAL;
+			}
+			else if ((matchCount = findDurationsBetween(library, low, high, &matches)) < 0)
+			{
+				result = errno;
+			}
+			else
+			{
+				for (i = 0; i < matchCount; ++i)
+				{
+					printMovie(matches[i]);
+				}
+			}
+		}
+		else if (strcmp(command, "plan") == 0)
 		{
-			head  = appendMovie;
-			*list = appendMovie;
+			low        = strtod(argument, &remainder);
+			remainder += strspn(remainder, " \t");
+
+			if (remainder == argument)
+			{
+				fprintf(stderr, "Line %d: Expected a duration in hours.\n", lineNumber);
+				result = EINVAL;
+			}
+			else if ((result = parseGenreFilter(remainder, &filter)) != 0)
+			{
+				fprintf(stderr, "Line %d: Unknown genre in %s.\n", lineNumber, remainder);
+			}
+			else if (fillWatchlist(library, watchlist, low, filter) < 0)
+			{
+				result = errno;
+			}
+
+			free(filter);
+			filter = NULL;
 		}
-		else
+		else if (strcmp(command, "addgenre") == 0 || strcmp(command, "removegenre") == 0)
 		{
-			while (head->next != NULL)
+			if ((result = parseGenreFilter(argument, &filter)) != 0 || filter == NULL)
+			{
+				fprintf(stderr, "Line %d: Expected genres of the library.\n", lineNumber);
+				result = result != 0 ? result : EINVAL;
+			}
+			else if ((command[0] == 'a' ? moveGenreMovies(library, watchlist, filter) : moveGenreMovies(watchlist, library, filter)) < 0)
 			{
-				head = head->next;
+				result = errno;
+				fprintf(stderr, "Line %d: Failed to %s: %s\n", lineNumber, command, strerror(result));
 			}
 
-			head->next = appendMovie;
+			free(filter);
+			filter = NULL;
+		}
+		else if (strcmp(command, "addprefix") == 0)
+		{
+			if (*argument == '\0')
+			{
+				fprintf(stderr, "Line %d: Expected a title prefix.\n", lineNumber);
+				result = EINVAL;
+			}
+			else if (addPrefixMovies(library, watchlist, argument) < 0)
+			{
+				result = errno;
+				fprintf(stderr, "Line %d: Failed to %s: %s\n", lineNumber, command, strerror(result));
+			}
+		}
+		else if (strcmp(command, "union") == 0 || strcmp(command, "intersect") == 0)
+		{
+			if ((command[0] == 'u' ? uniteWatchlistFile(library, watchlist, argument) : intersectWatchlistFile(library, watchlist, argument)) < 0)
+			{
+				result = errno;
+				fprintf(stderr, "Line %d: Failed to %s %s: %s\n", lineNumber, command, argument, strerror(result));
+			}
+		}
+		else if (strcmp(command, "stats") == 0)
+		{
+			printStats();
+		}
+		else
+		{
+			fprintf(stderr, "Line %d: Unknown command %s.\n", lineNumber, command);
+			result = EINVAL;
 		}
 
-		appendMovie->next = NULL;
+		status = status == 0 ? result : status;
+
+		/*
+		// No adds are queued here, so no library pointers are held:
+		*/
+		trimLibraryCache(library);
 	}
 
+	result = flushBatchAdds(library, watchlist, adds, &addCount);
+	status = status == 0 ? result : status;
+
+	free(adds);
+
 	return status;
 }
 
+/*=========================================================================================================
+// Library Views
+//=======================================================================================================*/
+
 /*
-// Removes a given Movie from a given linked list of Movies.
+// A logical view of a shared library that is no longer modified. A Movie is hidden from the view
+// by setting the bit of its position in the library, so every view shares the library's nodes,
+// indexes and search index and costs one bit per Movie at most.
+*/
+typedef struct LibraryView
+{
+	MovieList* library;
+	uint64_t*  hidden;       /* allocated when the first Movie is hidden */
+	int        hiddenCount;
+} LibraryView;
+
+/*
+// Determines whether a given library Movie is hidden from a given view.
 //
-// [in] list	    - The linked list of Movies
-// [in] removeMovie - The Movie to remove
+// [in] view  - The library view
+// [in] movie - The library Movie
+*/
+bool isHiddenInView(const LibraryView* view, const Movie* movie)
+{
+	int position = 0;
+
+	if (view->hidden != NULL)
+	{
+		position = getMoviePosition(view->library, (Movie*)movie);
+	}
+
+	return view->hidden != NULL && position >= 0 && (view->hidden[position / 64] >> (position % 64) & 1) != 0;
+}
+
+/*
+// Hides or shows a given library Movie in a given view.
 //
-// Returns the removed Movie, or NULL on error.
+// [in] view   - The library view
+// [in] movie  - The library Movie
+// [in] hidden - Whether the Movie is to be hidden
+//
+// Returns error status code.
 */
-Movie* removeMovie(Movie** list, Movie* removeMovie)
+int setHiddenInView(LibraryView* view, const Movie* movie, bool hidden)
 {
-	int    status       = 0;
-	Movie* removedMovie = NULL;
-	Movie* prev         = NULL;
-	Movie* itr          = NULL;
+	int      status   = 0;
+	int      position = getMoviePosition(view->library, (Movie*)movie);
+	uint64_t bit      = 0;
 
-	if (status == 0)
+	if (position < 0)
 	{
-		if (list == NULL || *list == NULL || removeMovie == NULL)
-		{
-			status       = EINVAL;
-			removedMovie = NULL;
-		}
+		status = EINVAL;
+	}
+	else if (view->hidden == NULL)
+	{
+		view->hidden = calloc(view->library->count / 64 + 1, sizeof(uint64_t));
+		status       = view->hidden == NULL ? ENOMEM : 0;
 	}
 
 	if (status == 0)
 	{
-		if (removeMovie == *list)
+		bit = (uint64_t)1 << (position % 64);
+
+		if (hidden != ((view->hidden[position / 64] & bit) != 0))
 		{
-			*list        = removeMovie->next;
-			removedMovie = removeMovie;
+			view->hidden[position / 64] ^= bit;
+			view->hiddenCount           += hidden ? 1 : -1;
 		}
-		else
-		{
-			prev = *list;
-			itr = prev->next;
-
-			while (true)
-			{
-				if (itr == removeMovie)
-				{
-					prev->next   = itr->next;
-					removedMovie = itr;
-					itr->next    = NULL;
-					break;
-				}
+	}
 
-				if (itr->next == NULL)
-				{
-					status = EINVAL;
-					break;
-				}
+	return status;
+}
 
-				prev = itr;
-				itr  = itr->next;
-			}
-		}
-	}
+/*
+// Finds a Movie by its given title among the Movies a given view shows.
+//
+// [in] view  - The library view
+// [in] title - The title of the Movie to find
+//
+// Returns the library Movie, or NULL if not found or hidden.
+*/
+Movie* findInView(const LibraryView* view, char* title)
+{
+	Movie* movie = searchByTitle(view->library, title);
 
-	return removedMovie;
+	return movie != NULL && isHiddenInView(view, movie) ? NULL : movie;
 }
 
 /*
-// Removes a given Movie from a given linked list of Movies, and deletes it from memory.
+// Returns the count of Movies a given view shows.
 //
-// [in] list		- The linked list of Movies
-// [in] deleteMovie - The Movie to delete
+// [in] view - The library view
+*/
+int getViewCount(const LibraryView* view)
+{
+	return view->library->count - view->hiddenCount;
+}
+
+/*
+// Releases the bitmap of a given view, showing every Movie again.
 //
-// Returns 0 on success, -1 on failure.
+// [in] view - The library view
 */
-int deleteMovie(Movie** list, Movie* deleteMovie)
+void clearLibraryView(LibraryView* view)
 {
-	int    status = 0;
-	Movie* prev   = NULL;
-	Movie* itr    = NULL;
+	free(view->hidden);
 
-	if (status == 0)
-	{
-		if (list == NULL || *list == NULL || deleteMovie == NULL)
-		{
-			status = -1;
-		}
-	}
+	view->hidden      = NULL;
+	view->hiddenCount = 0;
+}
 
-	if (status == 0)
-	{
-		if (deleteMovie == *list)
-		{
-			*list = deleteMovie->next;
-			free(deleteMovie);
-		}
-		else
-		{
-			prev = *list;
-			itr = prev->next;
+/*=========================================================================================================
+// Server
+//=======================================================================================================*/
 
-			while (true)
-			{
-				if (itr == deleteMovie)
-				{
-					prev->next  = itr->next;
-					itr->next   = NULL;
-					free(deleteMovie);
-					break;
-				}
+#define SERVER_BACKLOG      64
+#define SESSION_BUFFER_SIZE (16 * 1024)
+#define SESSION_MAX_RESULTS 100  /* Movies listed per library search or genre */
+
+#ifdef _WIN32
+typedef SOCKET Socket;
+#define closeSocket closesocket
+#define SHUT_RDWR   SD_BOTH
+#else
+typedef int Socket;
+#define INVALID_SOCKET (-1)
+#define closeSocket    close
+#endif
 
-				if (itr->next == NULL)
-				{
-					status = -1;
-					break;
-				}
+/*
+// The state shared by every session. The library is not modified while the server runs, so
+// sessions read it without locking; each session sees it through its own LibraryView, with the
+// Movies of its watchlist hidden, and its watchlist holds copies of those Movies.
+*/
+typedef struct Server
+{
+	MovieList*      library;
+	Mutex           sessionsLock;  /* guards sessions and Session::finished */
+	struct Session* sessions;
+} Server;
 
-				prev = itr;
-				itr  = itr->next;
-			}
-		}
-	}
+/*
+// Encapsulates one client connection and its watchlist.
+*/
+typedef struct Session
+{
+	Server*         server;
+	Socket          socket;
+	Thread          thread;
+	LibraryView     view;
+	MoviePool       pool;       /* the watchlist's copies of library Movies */
+	MovieList       watchlist;
+	bool            finished;
+	char            input[SESSION_BUFFER_SIZE];
+	int             inputStart;
+	int             inputEnd;
+	char            output[SESSION_BUFFER_SIZE];
+	int             outputLength;
+	struct Session* next;
+} Session;
 
-	return status;
+/*
+// Returns the error status code of the last failed socket call.
+*/
+int getSocketStatus()
+{
+#ifdef _WIN32
+	return WSAGetLastError() == WSAEINTR ? EINTR : EIO;
+#else
+	return errno;
+#endif
 }
 
 /*
-// Deletes a given linked list of Movies from memory.
+// Sends the pending output of a given session to its client.
 //
-// [in] list - The linked list of Movies
+// [in] session - The session
 //
-// Returns 0 on success, -1 on failure.
+// Returns error status code.
 */
-int deleteList(Movie** list)
+int flushSession(Session* session)
 {
-	int    status = 0;
-	Movie* next   = NULL;
-	Movie* itr    = NULL;
+	int status = 0;
+	int offset = 0;
+	int sent   = 0;
 
-	if (status == 0)
+	while (status == 0 && offset < session->outputLength)
 	{
-		if (list == NULL || *list == NULL)
+		sent = (int)send(session->socket, session->output + offset, session->outputLength - offset, 0);
+
+		if (sent <= 0)
 		{
-			status = -1;
+			status = EPIPE;
 		}
-	}
-
-	if (status == 0)
-	{
-		itr  = *list;
-		
-		while (true)
+		else
 		{
-			next = itr->next;
-
-			free(itr);
-
-			if (next == NULL)
-			{
-				break;
-			}
-
-			itr = next;
+			offset += sent;
 		}
 	}
 
+	session->outputLength = 0;
+
 	return status;
 }
 
 /*
-// Prints a given Movie.
+// Makes room for a given count of characters in the output of a given session.
 //
-// [in] movie - The Movie to print
+// [in] session - The session
+// [in] length  - The count of characters about to be written
 */
-void printMovie(Movie* movie)
+void reserveSessionOutput(Session* session, int length)
 {
-	int status = 0;
-
-	if (status == 0)
+	if (session->outputLength > SESSION_BUFFER_SIZE - length)
 	{
-		if (movie == NULL)
-		{
-			status = EINVAL;
-		}
+		flushSession(session);
 	}
+}
 
-	if (status == 0)
-	{
-		printf("%s (%s, %.2f hours)\n", movie->title, movie->genre, movie->duration);
-	}
+/*
+// Writes a formatted line to the output of a given session.
+//
+// [in] session - The session
+// [in] format  - The format of the line
+// [in] ...     - Additional arguments for the format
+*/
+void printSession(Session* session, const char* format, ...)
+{
+	va_list arguments;
+	int     room   = 0;
+	int     length = 0;
 
-	if (status != 0)
+	reserveSessionOutput(session, 512);
+
+	room = SESSION_BUFFER_SIZE - session->outputLength;
+
+	va_start(arguments, format);
+	length = vsnprintf(session->output + session->outputLength, room, format, arguments);
+	va_end(arguments);
+
+	if (length > 0)
 	{
-		errno = status;
+		session->outputLength += length < room ? length : room - 1;
 	}
 }
 
 /*
-// Prints the Movies in a given linked list of Movies.
+// Writes a given Movie to the output of a given session, formatted as printMovie prints it.
 //
-// [in] list - The linked list of Movies to print
+// [in] session - The session
+// [in] movie   - The Movie
 */
-void printMovieList(Movie* list)
+void printSessionMovie(Session* session, const Movie* movie)
 {
-	int    status = 0;
-	Movie* itr    = NULL;
+	reserveSessionOutput(session, MOVIE_TEXT_CAPACITY);
 
-	if (status == 0)
-	{
-		if (list == NULL)
-		{
-			status = EINVAL;
-		}
-	}
+	session->outputLength += (int)formatMovie(session->output + session->outputLength, movie);
+}
 
-	if (status == 0)
+/*
+// Reads the next line sent by the client of a given session, without its line ending.
+//
+// [in]  session  - The session
+// [out] line     - The line buffer
+// [in]  capacity - The size of the line buffer; longer lines are truncated
+//
+// Returns true if a line was read, or false once the client has disconnected.
+*/
+bool readSessionLine(Session* session, char* line, int capacity)
+{
+	bool  found    = false;
+	bool  open     = true;
+	char* begin    = NULL;
+	char* newline  = NULL;
+	int   length   = 0;
+	int   received = 0;
+
+	while (!found && open)
 	{
-		itr = list;
+		begin   = session->input + session->inputStart;
+		newline = memchr(begin, '\n', session->inputEnd - session->inputStart);
 
-		while (true)
+		if (newline != NULL)
 		{
-			printMovie(itr);
+			length = (int)(newline - begin);
 
-			if (itr->next == NULL)
+			if (length > 0 && begin[length - 1] == '\r')
 			{
-				break;
+				--length;
 			}
 
-			itr = itr->next;
+			length = length < capacity ? length : capacity - 1;
+			memcpy(line, begin, length);
+			line[length] = '\0';
+
+			session->inputStart = (int)(newline - session->input) + 1;
+			found               = true;
+		}
+		else if (session->inputStart == 0 && session->inputEnd == SESSION_BUFFER_SIZE)
+		{
+			/*
+			// No line fits the buffer, so this is not a client of ours:
+			*/
+			open = false;
+		}
+		else
+		{
+			memmove(session->input, begin, session->inputEnd - session->inputStart);
+			session->inputEnd  -= session->inputStart;
+			session->inputStart = 0;
+
+			received = (int)recv(session->socket, session->input + session->inputEnd, SESSION_BUFFER_SIZE - session->inputEnd, 0);
+
+			if (received <= 0)
+			{
+				open = false;
+			}
+			else
+			{
+				session->inputEnd += received;
+			}
 		}
 	}
-	printf("\n");
+
+	return found;
 }
 
 /*
-// Computes the total duration in hours of a given linked list of movies.
-//
-// [in] list - The linked list of Movies
+// Prints up to SESSION_MAX_RESULTS of a given array of library Movies that the view of a given
+// session shows.
 //
-// Returns the computed duration.
+// [in] session - The session
+// [in] movies  - The library Movies
+// [in] count   - The count of library Movies
 */
-double computeDuration(Movie* list)
+void printSessionResults(Session* session, Movie** movies, int count)
 {
-	int    status   = 0;
-	double duration = 0.0;
-	Movie* itr      = NULL;
+	int shown = 0;
+	int i     = 0;
 
-	if (status == 0)
+	for (i = 0; i < count; ++i)
 	{
-		if (list == NULL)
+		if (!isHiddenInView(&session->view, movies[i]) && shown++ < SESSION_MAX_RESULTS)
 		{
-			status = EINVAL;
+			printSessionMovie(session, movies[i]);
 		}
 	}
 
-	if (status == 0)
+	if (shown > SESSION_MAX_RESULTS)
 	{
-		itr = list;
-
-		while (true)
-		{
-			duration += itr->duration;
-
-			if (itr->next == NULL)
-			{
-				break;
-			}
-
-			itr = itr->next;
-		}
+		printSession(session, "... and %d more.\n", shown - SESSION_MAX_RESULTS);
 	}
-
-	return duration;
 }
 
 /*
-// Searches for a Movie by its given title in a given linked list of Movies.
+// Applies a given command of a given session and writes its response, which always ends with a
+// line starting with "OK" or "ERR":
 //
-// [in] list  - The linked list of Movies
-// [in] title - The title of the Movie to search for
+//   add <title>                copy a library Movie to the end of the watchlist
+//   insert <position> <title>  copy a library Movie to a position (one-based) in the watchlist
+//   remove <title>             remove a Movie from the watchlist
+//   up <title>                 move a watchlist Movie up
+//   down <title>               move a watchlist Movie down
+//   print                      print the watchlist
+//   duration                   print the duration of the watchlist
+//   search <title>             look up a title in the library
+//   prefix <text>              list the library Movies whose titles start with the text
+//   partial <text>             list the library Movies whose titles contain the text, best first
+//   genre [<genre>]            list the library genres, or the library Movies of a genre
+//   sort <order>               sort the watchlist by title, duration or genre
+//   longest <count>            list the longest library Movies, longest first
+//   between <low> <high>       list the library Movies within a duration range in hours
 //
-// Returns the Movie with the given title, or NULL if not found.
+// Movies in the watchlist are hidden from the session's view of the library.
+//
+// [in] session  - The session
+// [in] command  - The command
+// [in] argument - The argument of the command
 */
-Movie* searchByTitle(Movie* list, char* title)
+void handleSessionCommand(Session* session, char* command, char* argument)
 {
-	int    status = 0;
-	Movie* movie  = NULL;
-	Movie* itr    = NULL;
+	MovieList*   library    = session->view.library;
+	MovieList*   watchlist  = &session->watchlist;
+	const char*  error      = NULL;
+	Movie*       movie      = NULL;
+	Movie*       copy       = NULL;
+	Movie**      matches    = NULL;
+	int          matchCount = 0;
+	int          position   = 0;
+	char*        remainder  = NULL;
+	GenreBucket* bucket     = NULL;
+	GenreBucket* taken      = NULL;
+	int          genreId    = 0;
+	SortedView*  view       = NULL;
+	double       low        = 0.0;
+	double       high       = 0.0;
+	char*        end        = NULL;
+	int          i          = 0;
+
+	if (strcmp(command, "add") == 0 || strcmp(command, "insert") == 0)
+	{
+		position = getCount(watchlist) + 1;
 
-	if (status == 0)
+		if (command[0] == 'i')
+		{
+			position = strtol(argument, &remainder, 10);
+			argument = remainder == argument ? NULL : remainder + strspn(remainder, " \t");
+		}
+
+		if (argument == NULL || *argument == '\0')
+		{
+			error = command[0] == 'i' ? "Expected a position and a library title" : "Expected a library title";
+		}
+		else if ((movie = findInView(&session->view, argument)) == NULL)
+		{
+			error = searchByTitle(watchlist, argument) != NULL ? "Already in the watchlist" : "Not found in the library";
+		}
+		else if (position < 1 || position > getCount(watchlist) + 1)
+		{
+			error = "Position out of range";
+		}
+		else if ((copy = copyMovieNode(&session->pool, movie)) == NULL || setHiddenInView(&session->view, movie, true) != 0)
+		{
+			error = "Out of memory";
+		}
+		else if (insertMovie(watchlist, copy, position - 1) != 0)
+		{
+			setHiddenInView(&session->view, movie, false);
+			error = "Out of memory";
+		}
+
+		if (error != NULL && copy != NULL)
+		{
+			releaseMovie(&session->pool, copy);
+		}
+	}
+	else if (strcmp(command, "remove") == 0 || strcmp(command, "up") == 0 || strcmp(command, "down") == 0)
 	{
-		if (list == NULL || title == NULL)
+		movie = searchByTitle(watchlist, argument);
+
+		if (movie == NULL)
 		{
-			status = EINVAL;
-			movie  = NULL;
+			error = "Not found in the watchlist";
+		}
+		else if (command[0] == 'r')
+		{
+			setHiddenInView(&session->view, searchByTitle(library, argument), false);
+			deleteMovie(watchlist, movie);
+		}
+		else if (command[0] == 'u' && movie->prev != 0)
+		{
+			swapWithNextMovie(watchlist, getMovie(movie->prev));
+		}
+		else if (command[0] == 'd' && movie->next != 0)
+		{
+			swapWithNextMovie(watchlist, movie);
+		}
+	}
+	else if (strcmp(command, "print") == 0)
+	{
+		for (movie = watchlist->head; movie != NULL; movie = getMovie(movie->next))
+		{
+			printSessionMovie(session, movie);
 		}
 	}
+	else if (strcmp(command, "duration") == 0)
+	{
+		printSession(session, "Duration is %.2f hours.\n", computeDuration(watchlist));
+	}
+	else if (strcmp(command, "search") == 0)
+	{
+		movie = findInView(&session->view, argument);
 
-	if (status == 0)
+		if (movie != NULL)
+		{
+			printSessionMovie(session, movie);
+		}
+		else if (searchByTitle(watchlist, argument) != NULL)
+		{
+			error = "Already in the watchlist";
+		}
+		else
+		{
+			error = "Not found in the library";
+		}
+	}
+	else if (strcmp(command, "prefix") == 0 || strcmp(command, "partial") == 0)
 	{
-		itr = list;
+		matchCount = command[1] == 'r' ? searchByPrefix(library, argument, &matches) : searchByPartialTitle(library, argument, &matches);
+
+		if (matchCount < 0)
+		{
+			error = "Failed to search the library";
+		}
+		else
+		{
+			printSessionResults(session, matches, matchCount);
+		}
 
-		while (true)
+		free(matches);
+	}
+	else if (strcmp(command, "genre") == 0)
+	{
+		if (*argument == '\0')
 		{
-			if (strcmp(itr->title, title) == 0)
+			/*
+			// The watchlist's genre index counts what this session's view hides:
+			*/
+			for (genreId = 0; genreId < library->genreBucketCount; ++genreId)
 			{
-				movie = itr;
-				break;
+				bucket = getGenreBucket(library, genreId);
+				taken  = getGenreBucket(watchlist, genreId);
+
+				if (bucket != NULL && (taken == NULL || taken->count < bucket->count))
+				{
+					printSession(session, "%s (%d movies, %.2f hours)\n", getGenreName(genreId),
+						bucket->count - (taken == NULL ? 0 : taken->count),
+						bucket->duration + bucket->durationCompensation - (taken == NULL ? 0.0 : taken->duration + taken->durationCompensation));
+				}
 			}
+		}
+		else if ((bucket = getGenreBucket(library, findGenreId(argument, hashTitle(argument)))) != NULL)
+		{
+			matches = malloc(bucket->count * sizeof(Movie*) + 1);
 
-			if (itr->next == NULL)
+			if (matches == NULL)
 			{
-				break;
+				error = "Out of memory";
 			}
+			else
+			{
+				for (movie = bucket->head; movie != NULL; movie = getMovie(movie->genreNext))
+				{
+					matches[matchCount++] = movie;
+				}
 
-			itr = itr->next;
+				printSessionResults(session, matches, matchCount);
+				free(matches);
+			}
+		}
+		else
+		{
+			error = "No such genre in the library";
 		}
 	}
-
-	return movie;
-}
-
-/*
-// Determines the position (zero-based) of a Movie by its given title in a given linked list of Movies.
-//
-// [in] list  - The linked list of Movies
-// [in] title - The title of the Movie to find position
-//
-// Returns the position of the Movie, or -1 if not found.
-*/
-int getNodePosition(Movie* list, char* title)
-{
-	int    position = -1;
-	int    index    = 0;
-	int    status   = 0;
-	Movie* itr      = NULL;
-
-	if (status == 0)
+	else if (strcmp(command, "sort") == 0)
 	{
-		if (list == NULL || title == NULL)
+		if (findMovieOrder(argument) < 0)
 		{
-			status = EINVAL;
+			error = "Expected title, duration or genre";
+		}
+		else
+		{
+			sortMovieList(watchlist, (MovieOrder)findMovieOrder(argument));
 		}
 	}
-
-	if (status == 0)
+	else if (strcmp(command, "longest") == 0)
 	{
-		index = 0;
-		itr   = list;
+		/*
+		// The library's duration view was built before serving, so this only reads it:
+		*/
+		position = strtol(argument, &remainder, 10);
+		view     = getSortedView(library, ByDuration);
 
-		while (true)
+		if (remainder == argument || position < 0)
 		{
-			if (strcmp(itr->title, title) == 0)
-			{
-				position = index;
-				break;
-			}
-
-			if (itr->next == NULL)
+			error = "Expected a count";
+		}
+		else if (view == NULL)
+		{
+			error = "Out of memory";
+		}
+		else
+		{
+			for (i = view->count - 1; i >= 0 && matchCount < position && matchCount < SESSION_MAX_RESULTS; --i)
 			{
-				break;
+				if (!isHiddenInView(&session->view, view->movies[i]))
+				{
+					printSessionMovie(session, view->movies[i]);
+					++matchCount;
+				}
 			}
-
-			itr = itr->next;
 		}
 	}
-	
-	return position;
-}
-
-/*
-// Enum of all options for adding a movie.
-*/
-typedef enum AddMovieMenuOption
-{
-	AddToBeginning = 1,
-	AddToEnd       = 2,
-	InsertWithin   = 3
-} AddMovieMenuOption;
-
-/*
-// Prints the menu for adding a movie.
-*/
-void printAddMovieMenu()
-{
-	printf("*** Add Movie Menu ***\n");
-	printf(" 1) Add to beginning\n");
-	printf(" 2) Add to end\n");
-	printf(" 3) Insert at a position\n");
-	printf("\n");
-}
-
-/*
-// Prompts for and returns a menu option for adding a movie.
-*/
-AddMovieMenuOption getAddMovieMenuOption()
-{
-	AddMovieMenuOption option = 0;
-
-	printAddMovieMenu();
+	else if (strcmp(command, "between") == 0)
+	{
+		low  = strtod(argument, &remainder);
+		high = strtod(remainder, &end);
 
-	option = promptForInt(1, 3, "Enter how you'd like to add: ");
-	printf("\n");
+		if (remainder == argument || end == remainder)
+		{
+			error = "Expected a shortest and a longest duration";
+		}
+		else if ((matchCount = findDurationsBetween(library, low, high, &matches)) < 0)
+		{
+			error = "Out of memory";
+		}
+		else
+		{
+			printSessionResults(session, matches, matchCount);
+		}
+	}
+	else
+	{
+		error = "Unknown command";
+	}
 
-	return option;
+	if (error != NULL)
+	{
+		printSession(session, "ERR %s.\n", error);
+	}
+	else
+	{
+		printSession(session, "OK\n");
+	}
 }
 
 /*
-// Handles a single menu option for adding a movie.
+// Serves the client of a given session until it disconnects or sends "quit", then discards its
+// watchlist.
 //
-// [in] option    - The menu option
-// [in] library   - The library of Movies
-// [in] watchlist - The watchlist of Movies
+// [in] session - The session
 */
-void handleAddMovieMenuOption(AddMovieMenuOption option, Movie* movie, Movie** library, Movie** watchlist)
+void runSession(void* session)
 {
-	int    position = 0;
-	int    count    = 0;
-	Movie* newMovie = NULL;
+	Session* self      = session;
+	Server*  server    = self->server;
+	char     line[300] = {0};
+	char*    command   = NULL;
+	char*    argument  = NULL;
+	bool     open      = true;
 
-	newMovie = createMovieNode(movie->title, movie->genre, movie->duration);
+	initMovieList(&self->watchlist);
 
-	switch (option)
+	self->watchlist.pool = &self->pool;
+	self->view.library   = server->library;
+
+	printSession(self, "OK %d movies in the library.\n", getViewCount(&self->view));
+	open = flushSession(self) == 0;
+
+	while (open && readSessionLine(self, line, sizeof(line)))
 	{
-		case AddToBeginning:
+		command = splitCommand(line, &argument);
+
+		if (*command == '\0' || *command == '#')
 		{
-			insertMovie(watchlist, newMovie, 0);
-			removeMovie(library, movie);
-			break;
+			continue;
 		}
 
-		case AddToEnd:
+		if (strcmp(command, "quit") == 0)
 		{
-			appendMovie(watchlist, newMovie);
-			removeMovie(library, movie);
-			break;
+			printSession(self, "OK\n");
+			open = false;
 		}
-
-		case InsertWithin:
+		else
 		{
-			count = getCount(*watchlist);
-
-			printf("Enter a position from 1 to %d to add the movie: ", count);
-			printf("\n");
-			position = promptForInt(1, count, "");
-
-			insertMovie(watchlist, newMovie, position - 1);
-			removeMovie(library, movie);
-			break;
+			handleSessionCommand(self, command, argument);
 		}
 
-		default:
+		if (flushSession(self) != 0)
 		{
-			fprintf(stderr, "Unhandled menu option for adding a movie.\n");
-			free(newMovie);
+			open = false;
 		}
 	}
+
+	deleteList(&self->watchlist);
+	destroyMoviePool(&self->pool);
+	clearLibraryView(&self->view);
+
+	/*
+	// The socket stays open until the session is marked finished, so runServer never shuts down a
+	// closed one:
+	*/
+	lockMutex(&server->sessionsLock);
+	self->finished = true;
+	unlockMutex(&server->sessionsLock);
+
+	closeSocket(self->socket);
 }
 
 /*
-// Handles menu selection and operations for adding a movie.
+// Joins and frees the sessions of a given server whose clients have disconnected.
 //
-// [in] library   - The library of Movies
-// [in] watchlist - The watchlist of Movies
+// [in] server - The server
 */
-void handleAddMovie(Movie** library, Movie** watchlist)
+void reapSessions(Server* server)
 {
-	AddMovieMenuOption option    = 0;
-	char               title[35] = {0};
-	Movie*             movie     = NULL;
+	Session** link    = NULL;
+	Session*  session = NULL;
 
-	promptFor(title, sizeof(title), "Enter the title of the movie to add: ");
-	printf("\n");
-	movie = searchByTitle(*library, title);
+	lockMutex(&server->sessionsLock);
 
-	if (movie != NULL)
+	for (link = &server->sessions; *link != NULL;)
 	{
-		option = getAddMovieMenuOption();
+		session = *link;
 
-		handleAddMovieMenuOption(option, movie, library, watchlist);
+		if (session->finished)
+		{
+			*link = session->next;
 
-		printf("%s added to the watchlist.\n", title);
-		printf("\n");
-	}
-	else
-	{
-		printf("%s not found in the library. Please search for movies before attempting to add.\n", title);
-		printf("\n");
+			joinThread(&session->thread);
+			free(session);
+		}
+		else
+		{
+			link = &session->next;
+		}
 	}
-}
-
-/*=========================================================================================================
-// Movie Library
-//=======================================================================================================*/
 
-/*
-// Enum of all library menu options.
-*/
-typedef enum LibraryMenuOption
-{
-	ViewAllMovies       = 1,
-	SearchLibrary       = 2,
-	AddMovieToWatchlist = 3,
-	BackToWatchlist     = 4
-} LibraryMenuOption;
+	unlockMutex(&server->sessionsLock);
+}
 
 /*
-// Prompts for the name of a text file and stores the contents as a linked list of Movies.
+// Serves a given library to any number of concurrent clients on a given TCP port, one thread and
+// one watchlist per connection; see handleSessionCommand for the line protocol. Returns only if
+// the server socket fails.
+//
+// [in] library - The library of Movies, fully loaded and left unmodified while serving
+// [in] port    - The TCP port
 //
-// Returns the linked list of Movies, or NULL on error.
+// Returns error status code.
 */
-Movie* loadMovieLibrary(char* fileName)
+int runServer(MovieList* library, int port)
 {
-	int    status    = 0;
-	FILE*  input     = NULL;
-	Movie* library   = NULL;
-	Movie* movie     = NULL;
-	char   title[35] = {0};
-	char   genre[35] = {0};
-	double duration  = 0.0;
-	char   line[100] = {0};
+	int                status   = 0;
+	Server             server   = {NULL, MUTEX_INITIALIZER, NULL};
+	Socket             listener = INVALID_SOCKET;
+	Socket             client   = INVALID_SOCKET;
+	struct sockaddr_in address;
+	Session*           session  = NULL;
+	int                reuse    = 1;
+#ifdef _WIN32
+	WSADATA            data;
+
+	if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+	{
+		status = EIO;
+	}
+#else
+	/*
+	// A client hanging up should fail its session's send, not end the process:
+	*/
+	signal(SIGPIPE, SIG_IGN);
+#endif
 
-	if (fileName == NULL)
+	server.library = library;
+
+	/*
+	// Sessions search the library concurrently, which is only read-only once its search index and
+	// duration view are up to date:
+	*/
+	if (status == 0 && (getTitleSearchIndex(library) == NULL || getSortedView(library, ByDuration) == NULL))
 	{
-		status = EINVAL;
+		status = ENOMEM;
 	}
 
+	memset(&address, 0, sizeof(address));
+	address.sin_family      = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port        = htons((unsigned short)port);
+
 	if (status == 0)
 	{
-		input = fopen(fileName, "r");
-		
-		if (input == NULL)
+		listener = socket(AF_INET, SOCK_STREAM, 0);
+
+		if (listener == INVALID_SOCKET)
 		{
-			status = errno;
+			status = getSocketStatus();
+		}
+	}
+
+	if (status == 0)
+	{
+		setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+		if (bind(listener, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listener, SERVER_BACKLOG) != 0)
+		{
+			status = getSocketStatus();
 		}
 	}
 
 	if (status == 0)
 	{
-		while (!feof(input))
+		printf("Serving %d movies on port %d.\n", getCount(library), port);
+		fflush(stdout);
+	}
+
+	while (status == 0)
+	{
+		client = accept(listener, NULL, NULL);
+
+		if (client == INVALID_SOCKET)
 		{
-			fgets(title, _countof(title), input);
-			title[strlen(title) - 1] = '\0';
-			
-			fgets(genre, _countof(genre), input);
-			genre[strlen(genre) - 1] = '\0';
+			status = getSocketStatus();
+			status = status == EINTR ? 0 : status;
+			continue;
+		}
 
-			fgets(line, _countof(line), input);
-			duration = strtod(line, NULL);
+		reapSessions(&server);
 
-			movie = createMovieNode(title, genre, duration);
+		session = calloc(1, sizeof(Session));
 
-			if (movie == NULL)
-			{
-				status = errno;	
-				break;
-			}
-			else
-			{
-				status = appendMovie(&library, movie);
-			}
+		if (session != NULL)
+		{
+			session->server = &server;
+			session->socket = client;
+		}
+
+		if (session == NULL || startThread(&session->thread, runSession, session) != 0)
+		{
+			fprintf(stderr, "Failed to start a session.\n");
+			closeSocket(client);
+			free(session);
+		}
+		else
+		{
+			lockMutex(&server.sessionsLock);
+			session->next   = server.sessions;
+			server.sessions = session;
+			unlockMutex(&server.sessionsLock);
 		}
 	}
 
-	if (status != 0)
+	/*
+	// Hang up on the remaining clients so their sessions finish:
+	*/
+	lockMutex(&server.sessionsLock);
+
+	for (session = server.sessions; session != NULL; session = session->next)
 	{
-		deleteList(&library);
-		errno = status;
+		if (!session->finished)
+		{
+			shutdown(session->socket, SHUT_RDWR);
+		}
+	}
+
+	unlockMutex(&server.sessionsLock);
+
+	while ((session = server.sessions) != NULL)
+	{
+		server.sessions = session->next;
+
+		joinThread(&session->thread);
+		free(session);
+	}
+
+	if (listener != INVALID_SOCKET)
+	{
+		closeSocket(listener);
 	}
 
-	fclose(input);
+#ifdef _WIN32
+	WSACleanup();
+#endif
 
-	return library;
+	return status;
 }
 
+#ifdef WATCHLIST_BENCHMARK
+/*=========================================================================================================
+// Benchmarks
+//=======================================================================================================*/
+
+#define BENCHMARK_MIN_SIZE         1000
+#define BENCHMARK_MAX_SIZE         10000000
+#define BENCHMARK_MAX_OPERATIONS   1000000  /* per benchmark of a per-Movie operation */
+#define BENCHMARK_WATCHLIST_SIZE   100000   /* largest watchlist for the insert and save/load runs */
+#define BENCHMARK_LIBRARY_FILE     "benchmark_library.txt"
+#define BENCHMARK_WATCHLIST_FILE   "benchmark_watchlist.txt"
+
+static uint64_t benchmarkRandomState = 88172645463325252ull;
+
 /*
-// Prints the library menu.
+// Returns the next value of the benchmarks' xorshift generator, so every run sees the same data.
 */
-void printLibraryMenu()
+uint64_t nextBenchmarkRandom()
 {
-	printf("*** Library Menu ***\n");
-	printf("1) View all movies\n");
-	printf("2) Search by title\n");
-	printf("3) Add a movie to watchlist\n");
-	printf("4) Back to watchlist\n");
-	printf("\n");
+	benchmarkRandomState ^= benchmarkRandomState << 13;
+	benchmarkRandomState ^= benchmarkRandomState >> 7;
+	benchmarkRandomState ^= benchmarkRandomState << 17;
+
+	return benchmarkRandomState;
 }
 
 /*
-// Prompts for and returns a library menu option choice.
+// Returns the peak resident set size of the process so far in KiB.
 */
-LibraryMenuOption getLibraryMenuOption()
+unsigned long long getPeakResidentKilobytes()
 {
-	LibraryMenuOption option = 0;
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters = {0};
 
-	printLibraryMenu();
+	GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
 
-	option = promptForInt(1, 4, "Enter a menu choice: ");
-	printf("\n");
+	return (unsigned long long)counters.PeakWorkingSetSize / 1024;
+#else
+	struct rusage usage = {0};
 
-	return option;
+	getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+	return (unsigned long long)usage.ru_maxrss / 1024;
+#else
+	return (unsigned long long)usage.ru_maxrss;
+#endif
+#endif
 }
 
+/*
+// Prints one benchmark result as a line of JSON.
 //
-// Handles a single library menu option.
-//
-// [in] option    - The library menu option
-// [in] library   - The library of Movies
-// [in] watchlist - The watchlist of Movies
-//
-void handleLibraryMenuOption(LibraryMenuOption option, Movie** library, Movie** watchlist)
+// [in] name       - The name of the benchmark
+// [in] size       - The size of the library
+// [in] operations - The count of operations timed
+// [in] seconds    - The time taken
+*/
+void reportBenchmark(const char* name, int size, int operations, double seconds)
 {
-	char title[35] = {0};
-
-	switch (option)
-	{
-		case ViewAllMovies:
-		{
-			printMovieList(*library);
-			break;
-		}
-
-		case SearchLibrary:
-		{
-			promptFor(title, sizeof(title), "Enter a title to search: ");
-			printf("\n");
-
-			if (searchByTitle(*library, title) != NULL)
-			{
-				printf("%s found in the library.\n", title);
-				printf("\n");
-			}
-			else
-			{
-				printf("%s not found in the library.\n", title);
-				printf("\n");
-			}
-			break;
-		}
-
-		case AddMovieToWatchlist:
-		{
-			pageBreak();
-
-			handleAddMovie(library, watchlist);
-			break;
-		}
-
-		default:
-		{
-			fprintf(stderr, "Unhandled Library option.\n");
-		}
-	}
+	printf("{\"benchmark\": \"%s\", \"size\": %d, \"operations\": %d, \"seconds\": %.6f, \"ns_per_op\": %.1f, \"ops_per_second\": %.0f, \"peak_rss_kb\": %llu}\n",
+	       name, size, operations, seconds, operations > 0 ? seconds * 1e9 / operations : 0.0,
+	       seconds > 0.0 ? operations / seconds : 0.0, getPeakResidentKilobytes());
+	fflush(stdout);
 }
 
 /*
-// Handles library menu selection and operations.
+// Writes a synthetic library of a given size in the library text format.
 //
-// [in] library   - The library of Movies
-// [in] watchlist - The watchlist of Movies
+// [in] fileName - The name of the file to write
+// [in] size     - The count of Movies
+//
+// Returns error status code.
 */
-void handleLibrary(Movie** library, Movie** watchlist)
+int writeBenchmarkLibrary(const char* fileName, int size)
 {
-	LibraryMenuOption option = 0;
-
-	while (true)
-	{
-		option = getLibraryMenuOption();
+	static const char* genres[] = { "Action", "Comedy", "Crime", "Documentary", "Drama", "Fantacy", "Horror", "Mystery", "Science Fiction" };
 
-		if (option == BackToWatchlist)
-		{
-			break;
-		}
+	int   status = 0;
+	FILE* output = fopen(fileName, "w");
+	int   i      = 0;
 
-		handleLibraryMenuOption(option, library, watchlist);
+	if (output == NULL)
+	{
+		status = errno;
+	}
 
-		pageBreak();
+	for (i = 0; status == 0 && i < size; ++i)
+	{
+		fprintf(output, "%sMOVIE %d\n%s\n%.2f", i == 0 ? "" : "\n", i, genres[nextBenchmarkRandom() % _countof(genres)],
+		        1.0 + (double)(nextBenchmarkRandom() % 400) / 100.0);
 	}
-}
 
-/*=========================================================================================================
-// Movie Watchlist
-//=======================================================================================================*/
+	if (output != NULL && fclose(output) != 0 && status == 0)
+	{
+		status = errno;
+	}
 
-/*
-// Enum of all Watchlist menu options.
-*/
-typedef enum WatchlistMenuOption
-{
-	PrintWatchlist  = 1,
-	ShowDuration    = 2,
-	SearchWatchlist = 3,
-	MoveMovieUp     = 4,
-	MoveMovieDown   = 5,
-	RemoveMovie     = 6,
-	SaveWatchlist   = 7,
-	LoadWatchlist   = 8,
-	GoToLibrary     = 9,
-	Quit            = 10
-} WatchlistMenuOption;
+	return status;
+}
 
 /*
-// Prompts for the name of a text file and stores the given linked list of Movies into that text file.
+// Runs every benchmark against a synthetic library of a given size.
 //
-// [in] list - The linked list of Movies
+// [in] size - The count of Movies in the library
 //
 // Returns error status code.
 */
-int saveMovieWatchlist(Movie* list)
+int runBenchmarkSize(int size)
 {
-	int   status        = 0;
-	char  fileName[200] = {0};
-	FILE* output        = NULL;
+	int          status                      = 0;
+	MovieList    library                     = {0};
+	MovieList    watchlist                   = {0};
+	MovieList    reloaded                    = {0};
+	IngestReport report                      = {0};
+	char         title[MAX_TITLE_LENGTH + 1] = {0};
+	char*        journal                     = NULL;
+	char*        snapshot                    = NULL;
+	int          operations                  = 0;
+	int          found                       = 0;
+	int          i                           = 0;
+	double       start                       = 0.0;
+	double       total                       = 0.0;
+	double       compensation                = 0.0;
+	int          passes                      = 0;
+	Movie*       movie                       = NULL;
+
+	status = writeBenchmarkLibrary(BENCHMARK_LIBRARY_FILE, size);
+
+	if (status == 0)
+	{
+		start  = getSeconds();
+		status = loadMovieLibrary(BENCHMARK_LIBRARY_FILE, &library, &report);
+		reportBenchmark("loadMovieLibrary", size, size, getSeconds() - start);
+		clearIngestReport(&report);
+	}
+
+	if (status == 0)
+	{
+		start  = getSeconds();
+		status = loadMovieLibraryLazy(BENCHMARK_LIBRARY_FILE, &reloaded, &report);
+		reportBenchmark("loadMovieLibraryLazy", size, size, getSeconds() - start);
+		clearIngestReport(&report);
+		deleteLibrary(&reloaded);
+	}
+
+	/*
+	// The first start writes the snapshot, the second maps it:
+	*/
+	if (status == 0)
+	{
+		start  = getSeconds();
+		status = loadMovieLibraryWithSnapshot(BENCHMARK_LIBRARY_FILE, &reloaded, &report);
+		reportBenchmark("writeLibrarySnapshot", size, size, getSeconds() - start);
+		clearIngestReport(&report);
+		deleteLibrary(&reloaded);
+	}
+
+	if (status == 0)
+	{
+		start  = getSeconds();
+		status = loadMovieLibraryWithSnapshot(BENCHMARK_LIBRARY_FILE, &reloaded, &report);
+		reportBenchmark("loadLibrarySnapshot", size, size, getSeconds() - start);
+		clearIngestReport(&report);
+		deleteLibrary(&reloaded);
+	}
 
 	if (status == 0)
 	{
-		if (list == NULL)
+		operations = size < BENCHMARK_MAX_OPERATIONS ? size : BENCHMARK_MAX_OPERATIONS;
+		start      = getSeconds();
+
+		for (i = 0; i < operations; ++i)
 		{
-			status = EINVAL;
+			sprintf(title, "MOVIE %d", (int)(nextBenchmarkRandom() % size));
+			found += searchByTitle(&library, title) != NULL;
 		}
+
+		reportBenchmark("searchByTitle", size, operations, getSeconds() - start);
+		status = found == operations ? 0 : EILSEQ;
 	}
 
 	if (status == 0)
 	{
-		promptFor(fileName, sizeof(fileName), "Enter the name of the file to save watchlist to: ");
-		printf("\n");
+		operations = BENCHMARK_MAX_OPERATIONS;
+		start      = getSeconds();
 
-		output = fopen(fileName, "w");
-
-		if (output == NULL)
+		for (i = 0; i < operations; ++i)
 		{
-			status = errno;
+			total += computeDuration(&library);
 		}
+
+		reportBenchmark("computeDurationCached", size, operations, getSeconds() - start);
+		status = total > 0.0 ? 0 : EILSEQ;
 	}
 
+	/*
+	// The full walk that the maintained total replaced, timed per Movie summed:
+	*/
 	if (status == 0)
 	{
-		while (true)
+		passes = size < BENCHMARK_MAX_OPERATIONS ? BENCHMARK_MAX_OPERATIONS / size : 1;
+		total  = 0.0;
+		start  = getSeconds();
+
+		for (i = 0; i < passes; ++i)
 		{
-			fprintf(output, "%s\n%s\n%.2f", list->title, list->genre, list->duration);
+			compensation = 0.0;
 
-			if (list->next == NULL)
+			for (movie = library.head; movie != NULL; movie = getMovie(movie->next))
 			{
-				break;
+				addCompensated(&total, &compensation, movie->duration);
 			}
-
-			fprintf(output, "\n");
-			list = list->next;
 		}
 
-
+		reportBenchmark("recomputeDuration", size, passes * size, getSeconds() - start);
+		status = total > 0.0 ? 0 : EILSEQ;
 	}
 
-	fclose(output);
+	/*
+	// The watchlist holds new Movies, so the reload below finds nothing to reconcile:
+	*/
+	operations = size < BENCHMARK_WATCHLIST_SIZE ? size : BENCHMARK_WATCHLIST_SIZE;
+	total      = 0.0;
 
-	return status;
-}
+	for (i = 0; status == 0 && i < operations; ++i)
+	{
+		sprintf(title, "WATCH %d", i);
+		movie = createMovieNode(title, "Drama", 2.0);
 
-//
-// Prompts for the name of a text file and stores the contents as a linked list of Movies.
-//
-// Returns the linked list of Movies, or NULL on error.
-//
-Movie* loadMovieWatchlist(Movie** library)
-{
-	int    status        = 0;
-	char   fileName[200] = {0};
-	FILE*  input         = NULL;
-	char   line[100]     = {0};
-	Movie* watchlist     = NULL;
-	Movie* temp          = NULL;
-	Movie* movie         = NULL;
-	char   title[35]     = {0};
-	char   genre[35]     = {0};
-	double duration      = 0.0;
+		start   = getSeconds();
+		status  = movie == NULL ? errno : insertMovie(&watchlist, movie, (int)(nextBenchmarkRandom() % (watchlist.count + 1)));
+		total  += getSeconds() - start;
+	}
 
 	if (status == 0)
 	{
-		promptFor(fileName, sizeof(fileName), "Enter the name of the file to read the watchlist from: ");
-		printf("\n");
+		reportBenchmark("insertMovie", size, operations, total);
 
-		input = fopen(fileName, "r");
+		start  = getSeconds();
+		status = saveMovieWatchlistFile(&watchlist, BENCHMARK_WATCHLIST_FILE);
+		reportBenchmark("saveMovieWatchlist", size, operations, getSeconds() - start);
+	}
 
-		if (input == NULL)
-		{
-			status = errno;
-		}
+	if (status == 0)
+	{
+		start  = getSeconds();
+		status = finishWatchlistSave(&watchlist);
+		reportBenchmark("finishWatchlistSave", size, operations, getSeconds() - start);
 	}
 
 	if (status == 0)
 	{
-		while (!feof(input))
-		{
-			fgets(title, _countof(title), input);
-			title[strlen(title) - 1] = '\0';
+		start  = getSeconds();
+		status = loadMovieWatchlistFile(&library, &reloaded, BENCHMARK_WATCHLIST_FILE);
+		reportBenchmark("loadMovieWatchlist", size, operations, getSeconds() - start);
+	}
 
-			fgets(genre, _countof(genre), input);
-			genre[strlen(genre) - 1] = '\0';
+	if (status == 0)
+	{
+		start = getSeconds();
+		deleteLibrary(&library);
+		reportBenchmark("deleteList", size, size, getSeconds() - start);
+	}
 
-			fgets(line, _countof(line), input);
-			duration = strtod(line, NULL);
+	deleteLibrary(&library);
+	deleteList(&watchlist);
+	deleteList(&reloaded);
 
-			movie = createMovieNode(title, genre, duration);
+	journal = getJournalName(BENCHMARK_WATCHLIST_FILE);
 
-			if (movie == NULL)
-			{
-				status = errno;
-				break;
-			}
-			else
-			{
-				appendMovie(&watchlist, movie);
+	if (journal != NULL)
+	{
+		remove(journal);
+		free(journal);
+	}
 
-				temp = searchByTitle(*library, movie->title);
+	snapshot = getSuffixedName(BENCHMARK_LIBRARY_FILE, LIBRARY_SNAPSHOT_SUFFIX);
 
-				if (temp != NULL)
-				{
-					removeMovie(library, temp);
-				}
-			}
-		}
+	if (snapshot != NULL)
+	{
+		remove(snapshot);
+		free(snapshot);
 	}
 
-	fclose(input);
+	remove(BENCHMARK_WATCHLIST_FILE);
+	remove(BENCHMARK_LIBRARY_FILE);
 
-	return watchlist;
+	return status;
 }
 
 /*
-// Prints the Watchlist menu.
+// Runs the benchmarks at each power of ten from BENCHMARK_MIN_SIZE up to a given size, printing one
+// line of JSON per result. The working files are written to and removed from the current
+// directory.
+//
+// [in] argc - The count of arguments
+// [in] argv - The arguments; argv[1] optionally overrides the largest size
+//
+// Returns error status code.
 */
-void printWatchlistMenu()
+int runBenchmarks(int argc, char** argv)
 {
-	printf("*** Watchlist Menu ***\n");
-	printf(" 1) Print watchlist\n");
-	printf(" 2) Show duration\n");
-	printf(" 3) Search by title\n");
-	printf(" 4) Move a movie up\n");
-	printf(" 5) Move a movie down\n");
-	printf(" 6) Remove a movie\n");
-	printf(" 7) Save watchlist\n");
-	printf(" 8) Load watchlist\n");
-	printf(" 9) Go to movie library\n");
-	printf("10) Quit\n");
-	printf("\n");
+	int status  = 0;
+	int maximum = argc > 1 ? atoi(argv[1]) : BENCHMARK_MAX_SIZE;
+	int size    = 0;
+
+	for (size = BENCHMARK_MIN_SIZE; status == 0 && size <= maximum; size *= 10)
+	{
+		status = runBenchmarkSize(size);
+
+		if (size > INT32_MAX / 10)
+		{
+			break;
+		}
+	}
+
+	if (status != 0)
+	{
+		fprintf(stderr, "Benchmark failed: %s\n", strerror(status));
+	}
+
+	destroyMoviePool(&moviePool);
+	clearGenreTable();
+
+	return status;
 }
 
 /*
-// Prompts for and returns a Watchlist menu option choice.
+// Benchmark entry point, see runBenchmarks.
 */
-WatchlistMenuOption getWatchlistMenuOption()
+int main(int argc, char** argv)
 {
-	WatchlistMenuOption option = 0;
-
-	printWatchlistMenu();
-
-	option = promptForInt(1, 10, "Enter a menu choice: ");
-	printf("\n");
-
-	return option;
+	return runBenchmarks(argc, argv);
 }
 
+#else
+/*=========================================================================================================
 //
-// Handles a single Watchlist menu option.
-//
-// [in] option    - The library menu option
-// [in] library   - The library of Movies
-// [in] watchlist - The watchlist of Movies
+// Program entry point. argv[1] reserved for Movie text file, optionally followed by more library
+// files to load together with it (see loadMovieLibraries) and then by:
 //
-void handleWatchlistMenuOption(WatchlistMenuOption option, Movie** library, Movie** watchlist)
+//   --batch <file>  run the commands in the file (or stdin for "-") instead of the menus, see runBatch
+//   --lazy          decode library records only as they are looked up, see loadMovieLibraryLazy
+//   --stats <file>  write the counters and command latencies to the file on exit, see Stats
+//   --serve <port>  serve watchlist sessions over TCP instead of the menus, see runServer
+//   --clean <file>  write the library, less the records the ingest report drops, to the file
+*/
+int main(int argc, char** argv)
 {
-	char   title[35] = {0};
-	Movie* temp      = NULL;
-	Movie* newMovie  = NULL;
-	Movie* itr       = NULL;
+	int          status                    = 0;
+	MovieList    watchlist                 = {0};
+	MovieList    library                   = {0};
+	IngestReport reports[MAX_CATALOGS + 1] = {{0}};
+	FILE*        batch                     = NULL;
+	bool         lazy                      = false;
+	bool         snapshot                  = false;
+	char*        statsFile                 = NULL;
+	char*        cleanFile                 = NULL;
+	int          libraryCount              = 1;
+	int          port                      = 0;
+	int          i                         = 0;
 
-	switch (option)
+	if (status == 0)
 	{
-		case PrintWatchlist:
+		if (argc < 2)
 		{
-			printMovieList(*watchlist);
-			break;
+			status = E2BIG;
 		}
+	}
 
-		case ShowDuration:
+	while (1 + libraryCount < argc && strncmp(argv[1 + libraryCount], "--", 2) != 0)
+	{
+		++libraryCount;
+	}
+
+	for (i = 1 + libraryCount; status == 0 && i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--lazy") == 0)
 		{
-			printf("Duration is %.2f hours.\n", computeDuration(*watchlist));
-			printf("\n");
-			break;
+			lazy = true;
 		}
-
-		case SearchWatchlist:
+		else if (strcmp(argv[i], "--snapshot") == 0)
 		{
-			promptFor(title, sizeof(title), "Enter a title to search: ");
-			printf("\n");
-
-			if (searchByTitle(*watchlist, title) != NULL)
-			{
-				printf("%s found in the watchlist.\n", title);
-				printf("\n");
-			}
-			else
-			{
-				printf("%s not found in the watchlist.\n", title);
-				printf("\n");
-			}
-			break;
+			snapshot = true;
 		}
-
-		case MoveMovieUp:
+		else if (strcmp(argv[i], "--batch") == 0 && i + 1 < argc && batch == NULL)
 		{
-			promptFor(title, sizeof(title), "Enter the title of the movie to move up: ");
-			printf("\n");
-
-			if (searchByTitle(*watchlist, title) != NULL)
-			{
-				itr = *watchlist;
-
-				if (strcmp(itr->title, title) != 0)
-				{
-					while (true)
-					{
-						if (strcmp(itr->next->title, title) == 0)
-						{
-							if (itr == *watchlist)
-							{
-								*watchlist = itr->next;
-							}
+			++i;
+			batch = strcmp(argv[i], "-") == 0 ? stdin : fopen(argv[i], "r");
 
-							temp            = itr->next->next;
-							itr->next->next = itr;
-							itr->next       = temp;
-
-							break;
-						}
-
-						itr = itr->next;
-					}
-				}
-			}
-			else
+			if (batch == NULL)
 			{
-				printf("%s not found in the watchlist. Please search for movies before attempting to move.\n", title);
-				printf("\n");
+				status = errno;
+				perror(argv[i]);
 			}
-			break;
 		}
-
-		case MoveMovieDown:
+		else if (strcmp(argv[i], "--stats") == 0 && i + 1 < argc)
 		{
-			promptFor(title, sizeof(title), "Enter the title of the movie to move down: ");
-			printf("\n");
-
-			if (searchByTitle(*watchlist, title) != NULL)
-			{
-				itr = *watchlist;
-
-				while (itr->next != NULL)
-				{
-					if (strcmp(itr->title, title) == 0)
-					{
-						if (itr == *watchlist)
-						{
-							*watchlist = itr->next;
-						}
-
-						temp            = itr->next->next;
-						itr->next->next = itr;
-						itr->next       = temp;
-
-						break;
-					}
-
-					itr = itr->next;
-				}
-			}
-			else
-			{
-				printf("%s not found in the watchlist. Please search for movies before attempting to move.\n", title);
-				printf("\n");
-			}
-			break;
+			statsFile = argv[++i];
 		}
-
-		case RemoveMovie:
+		else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc)
 		{
-			promptFor(title, sizeof(title), "Enter the title of the movie to remove: ");
-			printf("\n");
-			temp = searchByTitle(*watchlist, title);
+			port   = atoi(argv[++i]);
+			status = port > 0 && port < 65536 ? 0 : E2BIG;
+		}
+		else if (strcmp(argv[i], "--clean") == 0 && i + 1 < argc)
+		{
+			cleanFile = argv[++i];
+		}
+		else
+		{
+			status = E2BIG;
+		}
+	}
 
-			if (temp != NULL)
-			{
-				newMovie = createMovieNode(temp->title, temp->genre, temp->duration);
-				removeMovie(watchlist, temp);
-				appendMovie(library, newMovie);
-			}
-			else
-			{
-				printf("%s not found in the watchlist. Please search for movies before attempting to remove.\n", title);
-				printf("\n");
-			}
+	/*
+	// Sessions share the library, so it must not change under lookups the way a lazy one does:
+	*/
+	if (status == 0 && port != 0 && (lazy || batch != NULL))
+	{
+		status = E2BIG;
+	}
 
-			break;
-		}
+	/*
+	// A lazy library holds only the records looked up so far, so it cannot be written out whole:
+	*/
+	if (status == 0 && cleanFile != NULL && lazy)
+	{
+		status = E2BIG;
+	}
 
-		case SaveWatchlist:
+	/*
+	// Likewise a lazy library reads from one file, and a snapshot is taken of one file's library:
+	*/
+	if (status == 0 && (libraryCount > MAX_CATALOGS || (libraryCount > 1 && (lazy || snapshot)) || (lazy && snapshot)))
+	{
+		status = E2BIG;
+	}
+
+	if (status == 0)
+	{
+		if (libraryCount > 1)
 		{
-			saveMovieWatchlist(*watchlist);
-			break;
+			status = loadMovieLibraries(argv + 1, libraryCount, &library, reports);
 		}
-
-		case LoadWatchlist:
+		else if (lazy)
 		{
-			*watchlist = loadMovieWatchlist(library);
-			break;
+			status = loadMovieLibraryLazy(argv[1], &library, &reports[0]);
 		}
-
-		case GoToLibrary:
+		else if (snapshot)
 		{
-			pageBreak();
-
-			handleLibrary(library, watchlist);
-			break;
+			status = loadMovieLibraryWithSnapshot(argv[1], &library, &reports[0]);
 		}
-
-		default:
+		else
 		{
-			fprintf(stderr, "Unhandled watchlist option.\n");
+			status = loadMovieLibrary(argv[1], &library, &reports[0]);
 		}
 	}
-}
-
-/*
-// Handles Watchlist menu selection and operations.
-//
-// [in] library   - The library of Movies
-// [in] watchlist - The watchlist of Movies
-*/
-void handleWatchlist(Movie** library, Movie** watchlist)
-{
-	WatchlistMenuOption option = 0;
 
-	while (true)
+	if (status == 0)
 	{
-		option = getWatchlistMenuOption();
-
-		if (option == Quit)
+		for (i = 0; i < libraryCount; ++i)
 		{
-			break;
+			printIngestReport(&reports[libraryCount > 1 ? i + 1 : 0], argv[1 + i], stderr);
 		}
 
-		handleWatchlistMenuOption(option, library, watchlist);
+		if (cleanFile != NULL)
+		{
+			status = writeMovieWatchlistFile(&library, cleanFile);
 
-		pageBreak();
+			if (status != 0)
+			{
+				fprintf(stderr, "%s: %s\n", cleanFile, strerror(status));
+			}
+		}
 	}
-}
 
-/*=========================================================================================================
-//
-// Program entry point. argv[1] reserved for Movie text file.
-*/
-int main(int argc, char** argv)
-{
-	int    status    = 0;
-	Movie* watchlist = NULL;
-	Movie* library   = NULL;
-
-	if (status == 0)
+	for (i = 0; i <= MAX_CATALOGS; ++i)
 	{
-		if (argc != 2)
-		{
-			status = E2BIG;
-		}
+		clearIngestReport(&reports[i]);
 	}
 
 	if (status == 0)
 	{
-		library = loadMovieLibrary(argv[1]);
+		if (batch != NULL)
+		{
+			setvbuf(stdout, NULL, _IOFBF, BATCH_OUTPUT_BUFFER_SIZE);
 
-		if (library == NULL)
+			status = runBatch(batch, &library, &watchlist);
+		}
+		else if (port != 0)
 		{
-			status = errno;
+			status = runServer(&library, port);
+		}
+		else
+		{
+			handleWatchlist(&library, &watchlist);
 		}
 	}
 
-	if (status == 0)
+	if (batch != NULL && batch != stdin)
 	{
-		handleWatchlist(&library, &watchlist);
+		fclose(batch);
 	}
 
 	deleteList(&watchlist);
-	deleteList(&library);
+	deleteLibrary(&library);
+	destroyMoviePool(&moviePool);
+	clearGenreTable();
+
+	/*
+	// Written last so the journal bytes flushed by deleteList are counted:
+	*/
+	if (statsFile != NULL)
+	{
+#ifdef WATCHLIST_STATS
+		if (saveStats(statsFile) != 0)
+		{
+			perror(statsFile);
+		}
+#else
+		fprintf(stderr, "Stats are not compiled into this build; %s was not written.\n", statsFile);
+#endif
+	}
 
 	return status;
 }
+#endif